@@ -3,19 +3,29 @@
 uniform vec4 u_const1;
 uniform vec4 u_const2;
 uniform vec4 u_const3;
-uniform vec4 u_light_ambient;
-uniform vec4 u_light_diffuse;
-uniform vec3 u_light_dir;
 uniform bool u_light_enable;
-uniform vec4 u_light_specular;
-uniform vec4 u_material_ambient;
-uniform vec4 u_material_diffuse;
-uniform vec4 u_material_specular;
-uniform int u_material_specular_mode;
-uniform float u_material_specular_power;
 uniform int u_mode;
-uniform vec4 u_rim_color;
-uniform float u_rim_power;
+
+// Constant for the whole program, uploaded once by Shader::initialize().
+layout(std140) uniform u_light_block
+{
+    vec4 u_light_ambient;
+    vec4 u_light_diffuse;
+    vec4 u_light_specular;
+    vec3 u_light_dir;
+    vec4 u_rim_color;
+    float u_rim_power;
+};
+
+// One range of the static material buffer, picked per draw by the shape type.
+layout(std140) uniform u_material_block
+{
+    vec4 u_material_ambient;
+    vec4 u_material_diffuse;
+    vec4 u_material_specular;
+    int u_material_specular_mode;
+    float u_material_specular_power;
+};
 
 struct PS_PUSH_DATA
 {
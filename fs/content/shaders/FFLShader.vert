@@ -3,6 +3,7 @@
 uniform mat3 u_it;
 uniform mat4 u_mv;
 uniform mat4 u_proj;
+uniform bool u_instanced;
 
 layout(location = 0) out vec4 PARAM_0;
 layout(location = 1) out vec4 PARAM_1;
@@ -14,6 +15,11 @@ layout(location = 1) in vec3 a_normal;
 layout(location = 2) in vec4 a_position;
 layout(location = 3) in vec3 a_tangent;
 layout(location = 4) in vec2 a_texCoord;
+// Per-instance u_mv and u_it of instanced draws, one column per location.
+layout(location = 5) in mat4 a_instance_mv;
+layout(location = 9) in mat3 a_instance_it;
+mat4 mv;
+mat3 it;
 int stackIdxVar;
 int stateVar;
 vec4 RVar[128];
@@ -36,6 +42,8 @@ void fs_main()
 
 void main()
 {
+    mv = u_instanced ? a_instance_mv : u_mv;
+    it = u_instanced ? a_instance_it : u_it;
     stackIdxVar = 0;
     stateVar = 0;
     RVar[0u] = vec4(intBitsToFloat(gl_VertexID), intBitsToFloat(gl_InstanceID), 0.0, 0.0);
@@ -45,95 +53,95 @@ void main()
         float _68 = RVar[3u].w;
         float _73 = RVar[3u].w;
         float _86 = RVar[5u].x;
-        RVar[127u].x = u_proj[3].x * u_mv[3].w;
-        RVar[127u].y = _68 * u_mv[3].w;
-        RVar[127u].z = _73 * u_mv[3].z;
-        RVar[127u].w = u_proj[3].y * u_mv[3].w;
+        RVar[127u].x = u_proj[3].x * mv[3].w;
+        RVar[127u].y = _68 * mv[3].w;
+        RVar[127u].z = _73 * mv[3].z;
+        RVar[127u].w = u_proj[3].y * mv[3].w;
         RVar[7u].x = _86;
         float _105 = RVar[5u].y;
-        RVar[126u].y = u_proj[3].w * u_mv[3].w;
-        RVar[126u].z = u_proj[3].z * u_mv[3].w;
+        RVar[126u].y = u_proj[3].w * mv[3].w;
+        RVar[126u].z = u_proj[3].z * mv[3].w;
         RVar[7u].w = _105;
         float _117 = RVar[3u].z;
         float _121 = RVar[127u].y;
         float _125 = RVar[3u].z;
         float _129 = RVar[127u].z;
-        RVar[126u].x = u_proj[3].x * u_mv[2].w;
-        RVar[127u].y = (_117 * u_mv[2].w) + _121;
-        RVar[127u].z = (_125 * u_mv[2].z) + _129;
-        RVar[126u].w = u_proj[3].y * u_mv[2].w;
-        RVar[125u].y = u_proj[3].w * u_mv[2].w;
-        RVar[125u].z = u_proj[3].z * u_mv[2].w;
+        RVar[126u].x = u_proj[3].x * mv[2].w;
+        RVar[127u].y = (_117 * mv[2].w) + _121;
+        RVar[127u].z = (_125 * mv[2].z) + _129;
+        RVar[126u].w = u_proj[3].y * mv[2].w;
+        RVar[125u].y = u_proj[3].w * mv[2].w;
+        RVar[125u].z = u_proj[3].z * mv[2].w;
         float _168 = RVar[127u].w;
-        RVar[127u].x = (u_mv[3].z * u_proj[2].x) + RVar[127u].x;
-        RVar[127u].w = (u_mv[3].z * u_proj[2].y) + _168;
+        RVar[127u].x = (mv[3].z * u_proj[2].x) + RVar[127u].x;
+        RVar[127u].w = (mv[3].z * u_proj[2].y) + _168;
         float _186 = RVar[126u].z;
-        RVar[126u].y = (u_mv[3].z * u_proj[2].w) + RVar[126u].y;
-        RVar[126u].z = (u_mv[3].z * u_proj[2].z) + _186;
+        RVar[126u].y = (mv[3].z * u_proj[2].w) + RVar[126u].y;
+        RVar[126u].z = (mv[3].z * u_proj[2].z) + _186;
         float _198 = RVar[3u].y;
         float _202 = RVar[127u].y;
         float _206 = RVar[3u].y;
         float _210 = RVar[127u].z;
-        RVar[125u].x = u_proj[3].x * u_mv[1].w;
-        RVar[127u].y = (_198 * u_mv[1].w) + _202;
-        RVar[127u].z = (_206 * u_mv[1].z) + _210;
-        RVar[125u].w = u_proj[3].y * u_mv[1].w;
-        RVar[124u].y = u_proj[3].w * u_mv[1].w;
-        RVar[124u].z = u_proj[3].z * u_mv[1].w;
+        RVar[125u].x = u_proj[3].x * mv[1].w;
+        RVar[127u].y = (_198 * mv[1].w) + _202;
+        RVar[127u].z = (_206 * mv[1].z) + _210;
+        RVar[125u].w = u_proj[3].y * mv[1].w;
+        RVar[124u].y = u_proj[3].w * mv[1].w;
+        RVar[124u].z = u_proj[3].z * mv[1].w;
         float _248 = RVar[126u].w;
-        RVar[126u].x = (u_mv[2].z * u_proj[2].x) + RVar[126u].x;
-        RVar[126u].w = (u_mv[2].z * u_proj[2].y) + _248;
+        RVar[126u].x = (mv[2].z * u_proj[2].x) + RVar[126u].x;
+        RVar[126u].w = (mv[2].z * u_proj[2].y) + _248;
         float _266 = RVar[125u].z;
-        RVar[5u].y = (u_mv[2].z * u_proj[2].w) + RVar[125u].y;
-        RVar[0u].z = (u_mv[2].z * u_proj[2].z) + _266;
+        RVar[5u].y = (mv[2].z * u_proj[2].w) + RVar[125u].y;
+        RVar[0u].z = (mv[2].z * u_proj[2].z) + _266;
         float _281 = RVar[3u].w;
         float _286 = RVar[3u].w;
         float _295 = RVar[127u].w;
-        RVar[127u].x = (u_mv[3].y * u_proj[1].x) + RVar[127u].x;
-        RVar[125u].y = _281 * u_mv[3].x;
-        RVar[125u].z = _286 * u_mv[3].y;
-        RVar[127u].w = (u_mv[3].y * u_proj[1].y) + _295;
+        RVar[127u].x = (mv[3].y * u_proj[1].x) + RVar[127u].x;
+        RVar[125u].y = _281 * mv[3].x;
+        RVar[125u].z = _286 * mv[3].y;
+        RVar[127u].w = (mv[3].y * u_proj[1].y) + _295;
         float _315 = RVar[126u].z;
-        RVar[126u].y = (u_mv[3].y * u_proj[1].w) + RVar[126u].y;
-        RVar[126u].z = (u_mv[3].y * u_proj[1].z) + _315;
+        RVar[126u].y = (mv[3].y * u_proj[1].w) + RVar[126u].y;
+        RVar[126u].z = (mv[3].y * u_proj[1].z) + _315;
         float _327 = RVar[3u].x;
         float _331 = RVar[127u].z;
         float _340 = RVar[3u].x;
         float _344 = RVar[127u].y;
-        RVar[124u].x = u_mv[0].w * u_proj[3].x;
-        RVar[6u].z = (_327 * u_mv[0].z) + _331;
-        RVar[124u].w = u_mv[0].w * u_proj[3].y;
-        RVar[6u].w = (_340 * u_mv[0].w) + _344;
-        RVar[127u].y = u_mv[0].w * u_proj[3].w;
-        RVar[127u].z = u_mv[0].w * u_proj[3].z;
+        RVar[124u].x = mv[0].w * u_proj[3].x;
+        RVar[6u].z = (_327 * mv[0].z) + _331;
+        RVar[124u].w = mv[0].w * u_proj[3].y;
+        RVar[6u].w = (_340 * mv[0].w) + _344;
+        RVar[127u].y = mv[0].w * u_proj[3].w;
+        RVar[127u].z = mv[0].w * u_proj[3].z;
         float _377 = RVar[125u].w;
-        RVar[125u].x = (u_mv[1].z * u_proj[2].x) + RVar[125u].x;
-        RVar[125u].w = (u_mv[1].z * u_proj[2].y) + _377;
+        RVar[125u].x = (mv[1].z * u_proj[2].x) + RVar[125u].x;
+        RVar[125u].w = (mv[1].z * u_proj[2].y) + _377;
         float _395 = RVar[124u].z;
-        RVar[124u].y = (u_mv[1].z * u_proj[2].w) + RVar[124u].y;
-        RVar[124u].z = (u_mv[1].z * u_proj[2].z) + _395;
+        RVar[124u].y = (mv[1].z * u_proj[2].w) + RVar[124u].y;
+        RVar[124u].z = (mv[1].z * u_proj[2].z) + _395;
         float _409 = RVar[3u].z;
         float _413 = RVar[125u].y;
         float _417 = RVar[3u].z;
         float _421 = RVar[125u].z;
         float _429 = RVar[126u].w;
-        RVar[126u].x = (u_mv[2].y * u_proj[1].x) + RVar[126u].x;
-        RVar[125u].y = (_409 * u_mv[2].x) + _413;
-        RVar[125u].z = (_417 * u_mv[2].y) + _421;
-        RVar[126u].w = (u_mv[2].y * u_proj[1].y) + _429;
+        RVar[126u].x = (mv[2].y * u_proj[1].x) + RVar[126u].x;
+        RVar[125u].y = (_409 * mv[2].x) + _413;
+        RVar[125u].z = (_417 * mv[2].y) + _421;
+        RVar[126u].w = (mv[2].y * u_proj[1].y) + _429;
         float _449 = RVar[0u].z;
-        RVar[5u].y = (u_mv[2].y * u_proj[1].w) + RVar[5u].y;
-        RVar[0u].z = (u_mv[2].y * u_proj[1].z) + _449;
+        RVar[5u].y = (mv[2].y * u_proj[1].w) + RVar[5u].y;
+        RVar[0u].z = (mv[2].y * u_proj[1].z) + _449;
         float _460 = RVar[127u].x;
-        float _462 = (u_mv[3].x * u_proj[0].x) + _460;
+        float _462 = (mv[3].x * u_proj[0].x) + _460;
         float _468 = RVar[127u].w;
-        float _470 = (u_mv[3].x * u_proj[0].y) + _468;
+        float _470 = (mv[3].x * u_proj[0].y) + _468;
         RVar[123u].x = _462;
         RVar[123u].w = _470;
         float _482 = RVar[126u].y;
-        float _484 = (u_mv[3].x * u_proj[0].w) + _482;
+        float _484 = (mv[3].x * u_proj[0].w) + _482;
         float _490 = RVar[126u].z;
-        float _492 = (u_mv[3].x * u_proj[0].z) + _490;
+        float _492 = (mv[3].x * u_proj[0].z) + _490;
         float _494 = RVar[3u].w;
         RVar[127u].x = RVar[3u].w * _462;
         RVar[123u].y = _484;
@@ -142,35 +150,35 @@ void main()
         float _509 = RVar[3u].w;
         float _512 = RVar[3u].w;
         float _519 = RVar[124u].w;
-        RVar[124u].x = (u_mv[0].z * u_proj[2].x) + RVar[124u].x;
+        RVar[124u].x = (mv[0].z * u_proj[2].x) + RVar[124u].x;
         RVar[126u].y = _509 * _484;
         RVar[126u].z = _512 * _492;
-        RVar[124u].w = (u_mv[0].z * u_proj[2].y) + _519;
+        RVar[124u].w = (mv[0].z * u_proj[2].y) + _519;
         float _539 = RVar[127u].z;
-        RVar[127u].y = (u_mv[0].z * u_proj[2].w) + RVar[127u].y;
-        RVar[127u].z = (u_mv[0].z * u_proj[2].z) + _539;
+        RVar[127u].y = (mv[0].z * u_proj[2].w) + RVar[127u].y;
+        RVar[127u].z = (mv[0].z * u_proj[2].z) + _539;
         float _553 = RVar[3u].y;
         float _557 = RVar[125u].y;
         float _561 = RVar[3u].y;
         float _565 = RVar[125u].z;
         float _573 = RVar[125u].w;
-        RVar[125u].x = (u_mv[1].y * u_proj[1].x) + RVar[125u].x;
-        RVar[125u].y = (_553 * u_mv[1].x) + _557;
-        RVar[125u].z = (_561 * u_mv[1].y) + _565;
-        RVar[125u].w = (u_mv[1].y * u_proj[1].y) + _573;
+        RVar[125u].x = (mv[1].y * u_proj[1].x) + RVar[125u].x;
+        RVar[125u].y = (_553 * mv[1].x) + _557;
+        RVar[125u].z = (_561 * mv[1].y) + _565;
+        RVar[125u].w = (mv[1].y * u_proj[1].y) + _573;
         float _593 = RVar[124u].z;
-        RVar[124u].y = (u_mv[1].y * u_proj[1].w) + RVar[124u].y;
-        RVar[124u].z = (u_mv[1].y * u_proj[1].z) + _593;
+        RVar[124u].y = (mv[1].y * u_proj[1].w) + RVar[124u].y;
+        RVar[124u].z = (mv[1].y * u_proj[1].z) + _593;
         float _603 = RVar[126u].x;
-        float _605 = (u_mv[2].x * u_proj[0].x) + _603;
+        float _605 = (mv[2].x * u_proj[0].x) + _603;
         float _611 = RVar[126u].w;
-        float _613 = (u_mv[2].x * u_proj[0].y) + _611;
+        float _613 = (mv[2].x * u_proj[0].y) + _611;
         RVar[123u].x = _605;
         RVar[123u].w = _613;
         float _627 = RVar[5u].y;
-        float _629 = (u_mv[2].x * u_proj[0].w) + _627;
+        float _629 = (mv[2].x * u_proj[0].w) + _627;
         float _635 = RVar[0u].z;
-        float _637 = (u_mv[2].x * u_proj[0].z) + _635;
+        float _637 = (mv[2].x * u_proj[0].z) + _635;
         float _639 = RVar[3u].z;
         float _641 = RVar[127u].w;
         RVar[127u].x = (RVar[3u].z * _605) + RVar[127u].x;
@@ -184,27 +192,27 @@ void main()
         float _673 = RVar[124u].w;
         float _677 = RVar[3u].x;
         float _681 = RVar[125u].y;
-        RVar[124u].x = (u_mv[0].y * u_proj[1].x) + RVar[124u].x;
+        RVar[124u].x = (mv[0].y * u_proj[1].x) + RVar[124u].x;
         RVar[126u].y = (_657 * _629) + _659;
         RVar[126u].z = (_663 * _637) + _665;
-        RVar[124u].w = (u_mv[0].y * u_proj[1].y) + _673;
-        RVar[6u].x = (_677 * u_mv[0].x) + _681;
+        RVar[124u].w = (mv[0].y * u_proj[1].y) + _673;
+        RVar[6u].x = (_677 * mv[0].x) + _681;
         float _702 = RVar[127u].z;
         float _706 = RVar[3u].x;
         float _710 = RVar[125u].z;
-        RVar[127u].y = (u_mv[0].y * u_proj[1].w) + RVar[127u].y;
-        RVar[127u].z = (u_mv[0].y * u_proj[1].z) + _702;
-        RVar[6u].y = (_706 * u_mv[0].y) + _710;
+        RVar[127u].y = (mv[0].y * u_proj[1].w) + RVar[127u].y;
+        RVar[127u].z = (mv[0].y * u_proj[1].z) + _702;
+        RVar[6u].y = (_706 * mv[0].y) + _710;
         float _721 = RVar[125u].x;
-        float _723 = (u_mv[1].x * u_proj[0].x) + _721;
+        float _723 = (mv[1].x * u_proj[0].x) + _721;
         float _729 = RVar[125u].w;
-        float _731 = (u_mv[1].x * u_proj[0].y) + _729;
+        float _731 = (mv[1].x * u_proj[0].y) + _729;
         RVar[123u].x = _723;
         RVar[123u].w = _731;
         float _745 = RVar[124u].y;
-        float _747 = (u_mv[1].x * u_proj[0].w) + _745;
+        float _747 = (mv[1].x * u_proj[0].w) + _745;
         float _753 = RVar[124u].z;
-        float _755 = (u_mv[1].x * u_proj[0].z) + _753;
+        float _755 = (mv[1].x * u_proj[0].z) + _753;
         float _757 = RVar[3u].y;
         float _759 = RVar[127u].w;
         RVar[127u].x = (RVar[3u].y * _723) + RVar[127u].x;
@@ -212,21 +220,21 @@ void main()
         RVar[123u].z = _755;
         RVar[127u].w = (_757 * _731) + _759;
         float _771 = RVar[124u].x;
-        float _773 = (u_mv[0].x * u_proj[0].x) + _771;
+        float _773 = (mv[0].x * u_proj[0].x) + _771;
         float _775 = RVar[3u].y;
         float _777 = RVar[126u].y;
         float _781 = RVar[3u].y;
         float _783 = RVar[126u].z;
         float _791 = RVar[124u].w;
-        float _793 = (u_mv[0].x * u_proj[0].y) + _791;
+        float _793 = (mv[0].x * u_proj[0].y) + _791;
         RVar[123u].x = _773;
         RVar[126u].y = (_775 * _747) + _777;
         RVar[126u].z = (_781 * _755) + _783;
         RVar[123u].w = _793;
         float _809 = RVar[127u].y;
-        float _811 = (u_mv[0].x * u_proj[0].w) + _809;
+        float _811 = (mv[0].x * u_proj[0].w) + _809;
         float _817 = RVar[127u].z;
-        float _819 = (u_mv[0].x * u_proj[0].z) + _817;
+        float _819 = (mv[0].x * u_proj[0].z) + _817;
         float _821 = RVar[3u].x;
         float _823 = RVar[127u].w;
         RVar[0u].x = (RVar[3u].x * _773) + RVar[127u].x;
@@ -239,45 +247,45 @@ void main()
         float _847 = RVar[3u].x;
         float _849 = RVar[126u].y;
         float _853 = RVar[2u].z;
-        RVar[127u].x = RVar[2u].z * u_it[2].x;
-        RVar[126u].y = _836 * u_it[2].y;
+        RVar[127u].x = RVar[2u].z * it[2].x;
+        RVar[126u].y = _836 * it[2].y;
         RVar[0u].z = (_841 * _819) + _843;
         RVar[0u].w = (_847 * _811) + _849;
-        RVar[126u].z = _853 * u_it[2].z;
+        RVar[126u].z = _853 * it[2].z;
         float _869 = RVar[4u].z;
         float _874 = RVar[4u].z;
-        RVar[124u].x = RVar[4u].z * u_it[2].z;
+        RVar[124u].x = RVar[4u].z * it[2].z;
         float _880 = RVar[2u].y;
         float _884 = RVar[126u].y;
-        float _886 = (_880 * u_it[1].y) + _884;
+        float _886 = (_880 * it[1].y) + _884;
         float _888 = RVar[2u].y;
         float _892 = RVar[127u].x;
-        float _894 = (_888 * u_it[1].x) + _892;
+        float _894 = (_888 * it[1].x) + _892;
         float _896 = RVar[4u].y;
-        float _900 = (_896 * u_it[1].x) + (_874 * u_it[2].x);
+        float _900 = (_896 * it[1].x) + (_874 * it[2].x);
         float _902 = RVar[2u].y;
         float _906 = RVar[126u].z;
         float _910 = RVar[4u].y;
         RVar[123u].x = _886;
         RVar[123u].y = _894;
         RVar[123u].z = _900;
-        RVar[127u].w = (_902 * u_it[1].z) + _906;
-        RVar[126u].z = (_910 * u_it[1].y) + (_869 * u_it[2].y);
+        RVar[127u].w = (_902 * it[1].z) + _906;
+        RVar[126u].z = (_910 * it[1].y) + (_869 * it[2].y);
         float _927 = RVar[2u].x;
         float _933 = RVar[4u].y;
         float _937 = RVar[124u].x;
-        float _939 = (_933 * u_it[1].z) + _937;
+        float _939 = (_933 * it[1].z) + _937;
         float _941 = RVar[4u].x;
-        RVar[3u].x = (RVar[2u].x * u_it[0].x) + _894;
-        RVar[3u].y = (_927 * u_it[0].y) + _886;
+        RVar[3u].x = (RVar[2u].x * it[0].x) + _894;
+        RVar[3u].y = (_927 * it[0].y) + _886;
         RVar[123u].w = _939;
-        RVar[5u].x = (_941 * u_it[0].x) + _900;
+        RVar[5u].x = (_941 * it[0].x) + _900;
         float _959 = RVar[2u].x;
         float _963 = RVar[127u].w;
         float _967 = RVar[4u].x;
-        RVar[5u].y = (RVar[4u].x * u_it[0].y) + RVar[126u].z;
-        RVar[3u].z = (_959 * u_it[0].z) + _963;
-        RVar[5u].w = (_967 * u_it[0].z) + _939;
+        RVar[5u].y = (RVar[4u].x * it[0].y) + RVar[126u].z;
+        RVar[3u].z = (_959 * it[0].z) + _963;
+        RVar[5u].w = (_967 * it[0].z) + _939;
     }
     vec4 _991 = RVar[0u];
     vec4 _994 = _991;
@@ -7,10 +7,28 @@
 
 #if RIO_IS_CAFE
 #include <gx2/shaders.h>
+#elif RIO_IS_WIN
+#include <map>
+#include <utility>
 #endif // RIO_IS_CAFE
 
 class Shader
 {
+public:
+    // Pixel uniform writes and material buffer binds sent to the GPU, and the ones skipped because the value was already set.
+    struct UniformStats
+    {
+        u32 issued;
+        u32 skipped;
+    };
+
+    // Modelview and normal matrix of one instance, laid out like the u_mv and u_it uniforms.
+    struct InstanceData
+    {
+        rio::BaseMtx44f mv;
+        rio::BaseVec3f it[3];
+    };
+
 public:
     Shader();
     ~Shader();
@@ -20,6 +38,16 @@ public:
     void bind(bool light_enable) const;
 
     void setViewUniform(const rio::BaseMtx34f& model_mtx, const rio::BaseMtx34f& view_mtx, const rio::BaseMtx44f& proj_mtx) const;
+    void setProjUniform(const rio::BaseMtx44f& proj_mtx) const;
+    // Modelview and normal matrix already built by MatrixBatch::ViewNormal().
+    void setModelViewUniform(const rio::BaseMtx34f& mv_mtx, const rio::BaseMtx34f& it_mtx) const;
+
+    static void calcInstanceData(InstanceData* p_data, const rio::BaseMtx34f& mv_mtx, const rio::BaseMtx34f& it_mtx);
+
+#if RIO_IS_WIN
+    // Until the next bind, every draw is instanced count times with one InstanceData per instance from the buffer.
+    void setInstanceBuffer(u32 vbo_handle, u32 count);
+#endif
 
     void applyAlphaTestEnable() const
     {
@@ -35,11 +63,30 @@ public:
 
     static void setCulling(FFLCullMode mode);
 
+    // Vertex buffers are uploaded once per shape and reused until the CharModel they belong to is invalidated.
+    // Set the CharModel before drawing it, and invalidate it before it gets deleted or rebuilt with a new expression.
+    // Draws without a CharModel set, like the face textures of FFLInitCharModelGPUStep, are uploaded every time.
+    void setCharModel(const FFLCharModel* p_char_model);
+    void invalidateCharModel(const FFLCharModel* p_char_model);
+
+    // Call once per frame, getUniformStats() then returns the counts of the frame that just ended.
+    void endFrame();
+
+    const UniformStats& getUniformStats() const
+    {
+        return mLastFrameUniformStats;
+    }
+
 private:
     static void applyAlphaTestCallback_(void* p_obj, bool enable, rio::Graphics::CompareFunc func, f32 ref);
 
+    template <typename T>
+    void setPixelUniform_(u32 uniform, const T& value) const;
+    void invalidateUniformCache_() const;
+    void setInstanced_(bool instanced) const;
+
     void bindTexture_(const FFLModulateParam& modulateParam);
-    void setConstColor_(u32 ps_loc, const FFLColor& color);
+    void setConstColor_(u32 uniform, const FFLColor& color);
     void setModulateMode_(FFLModulateMode mode);
     void setModulate_(const FFLModulateParam& modulateParam);
 
@@ -51,12 +98,36 @@ private:
     void setMatrix_(const rio::BaseMtx44f& matrix);
     static void setMatrixCallback_(void* p_obj, const rio::BaseMtx44f& matrix);
 
+#if RIO_IS_WIN
+    struct DrawBuffer
+    {
+        u32         vaoHandle;
+        u32         vboHandle[FFL_ATTRIBUTE_BUFFER_TYPE_MAX];
+        u32         instanceVBOHandle;
+        const void* ptr[FFL_ATTRIBUTE_BUFFER_TYPE_MAX];
+        u32         size[FFL_ATTRIBUTE_BUFFER_TYPE_MAX];
+    };
+
+    // Keyed by the owning CharModel and the index buffer of the shape.
+    typedef std::pair<const FFLCharModel*, const void*> DrawBufferKey;
+
+    DrawBuffer& getDrawBuffer_(const FFLDrawParam& draw_param);
+    void createDrawBuffer_(DrawBuffer* p_buffer, const FFLDrawParam& draw_param) const;
+    static void destroyDrawBuffer_(DrawBuffer* p_buffer);
+    static bool isDrawBufferValid_(const DrawBuffer& buffer, const FFLDrawParam& draw_param);
+    void setConstantAttributes_(const FFLDrawParam& draw_param) const;
+    void bindInstanceBuffer_(DrawBuffer* p_buffer) const;
+
+    void initializeUniformBlocks_();
+#endif
+
 private:
     enum VertexUniform
     {
         VERTEX_UNIFORM_IT = 0,  // Inverse transpose of MV
         VERTEX_UNIFORM_MV,
         VERTEX_UNIFORM_PROJ,
+        VERTEX_UNIFORM_INSTANCED,
         VERTEX_UNIFORM_MAX
     };
 
@@ -78,21 +149,42 @@ private:
         PIXEL_UNIFORM_MODE,
         PIXEL_UNIFORM_RIM_COLOR,
         PIXEL_UNIFORM_RIM_POWER,
+        PIXEL_UNIFORM_ALPHA_FUNC,
+        PIXEL_UNIFORM_ALPHA_REF,
         PIXEL_UNIFORM_MAX
     };
 
+    // Last value written to a pixel uniform, big enough for a vec4.
+    struct UniformValue
+    {
+        u32  data[4];
+        bool valid;
+    };
+
     rio::Shader             mShader;
     s32                     mVertexUniformLocation[VERTEX_UNIFORM_MAX];
     s32                     mPixelUniformLocation[PIXEL_UNIFORM_MAX];
+    mutable UniformValue    mPixelUniformValue[PIXEL_UNIFORM_MAX];
+    mutable bool            mInstanced;
+    mutable UniformStats    mUniformStats;
+    UniformStats            mLastFrameUniformStats;
     s32                     mSamplerLocation;
     s32                     mAttributeLocation[FFL_ATTRIBUTE_BUFFER_TYPE_MAX];
 #if RIO_IS_CAFE
     GX2AttribStream         mAttribute[FFL_ATTRIBUTE_BUFFER_TYPE_MAX];
     GX2FetchShader          mFetchShader;
 #elif RIO_IS_WIN
-    u32                     mVBOHandle[FFL_ATTRIBUTE_BUFFER_TYPE_MAX];
     u32                     mVAOHandle;
+    u32                     mLightUBOHandle;
+    u32                     mMaterialUBOHandle;
+    u32                     mMaterialUBOStride;
+    mutable s32             mBoundMaterial;
+    mutable u32             mInstanceVBOHandle;
+    mutable u32             mInstanceCount;
+    std::map<DrawBufferKey, DrawBuffer> mDrawBuffers;
+    DrawBuffer              mScratchBuffer;
 #endif
+    const FFLCharModel*     mpCharModel;
     FFLShaderCallback       mCallback;
     rio::TextureSampler2D   mSampler;
 };
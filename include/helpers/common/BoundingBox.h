@@ -0,0 +1,129 @@
+#ifndef BOUNDINGBOXHELPER_H
+#define BOUNDINGBOXHELPER_H
+
+#include <rio.h>
+#include <math/rio_MathTypes.h>
+#include <math/rio_Vector.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+// Axis aligned box. A default constructed box is empty, adding a point makes it cover that point.
+struct BoundingBox
+{
+    rio::Vector3f min = {FLT_MAX, FLT_MAX, FLT_MAX};
+    rio::Vector3f max = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+
+    static inline BoundingBox FromCenter(const rio::Vector3f &pCenter, const rio::Vector3f &pHalfSize)
+    {
+        BoundingBox box;
+        box.min = {pCenter.x - pHalfSize.x, pCenter.y - pHalfSize.y, pCenter.z - pHalfSize.z};
+        box.max = {pCenter.x + pHalfSize.x, pCenter.y + pHalfSize.y, pCenter.z + pHalfSize.z};
+
+        return box;
+    }
+
+    inline bool IsEmpty() const { return min.x > max.x || min.y > max.y || min.z > max.z; };
+
+    inline rio::Vector3f GetCenter() const { return {(min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f, (min.z + max.z) * 0.5f}; };
+    inline rio::Vector3f GetHalfSize() const { return {(max.x - min.x) * 0.5f, (max.y - min.y) * 0.5f, (max.z - min.z) * 0.5f}; };
+
+    inline void Add(const rio::BaseVec3f &pPoint)
+    {
+        min = {std::min(min.x, pPoint.x), std::min(min.y, pPoint.y), std::min(min.z, pPoint.z)};
+        max = {std::max(max.x, pPoint.x), std::max(max.y, pPoint.y), std::max(max.z, pPoint.z)};
+    }
+
+    inline void Merge(const BoundingBox &pOther)
+    {
+        min = {std::min(min.x, pOther.min.x), std::min(min.y, pOther.min.y), std::min(min.z, pOther.min.z)};
+        max = {std::max(max.x, pOther.max.x), std::max(max.y, pOther.max.y), std::max(max.z, pOther.max.z)};
+    }
+
+    static inline BoundingBox Merge(const BoundingBox &pA, const BoundingBox &pB)
+    {
+        BoundingBox box = pA;
+        box.Merge(pB);
+
+        return box;
+    }
+
+    inline void Grow(f32 pMargin)
+    {
+        min = {min.x - pMargin, min.y - pMargin, min.z - pMargin};
+        max = {max.x + pMargin, max.y + pMargin, max.z + pMargin};
+    }
+
+    inline bool Contains(const BoundingBox &pOther) const
+    {
+        return min.x <= pOther.min.x && min.y <= pOther.min.y && min.z <= pOther.min.z &&
+               max.x >= pOther.max.x && max.y >= pOther.max.y && max.z >= pOther.max.z;
+    }
+
+    // Sum of the areas of the three faces that meet in a corner, half the real surface area. Only compared against each other.
+    inline f32 GetHalfArea() const
+    {
+        f32 x = max.x - min.x;
+        f32 y = max.y - min.y;
+        f32 z = max.z - min.z;
+
+        return x * y + y * z + z * x;
+    }
+
+    // Squared distance from pPoint to the closest point of the box, 0 inside.
+    inline f32 GetDistanceSq(const rio::BaseVec3f &pPoint) const
+    {
+        f32 x = std::max(std::max(min.x - pPoint.x, pPoint.x - max.x), 0.f);
+        f32 y = std::max(std::max(min.y - pPoint.y, pPoint.y - max.y), 0.f);
+        f32 z = std::max(std::max(min.z - pPoint.z, pPoint.z - max.z), 0.f);
+
+        return x * x + y * y + z * z;
+    }
+
+    // Slab test. pInvDirection is one over every component of the ray direction, infinities for zeros are fine.
+    // On a hit pDistance is where the ray enters the box, 0 if it starts inside.
+    inline bool IntersectRay(const rio::BaseVec3f &pOrigin, const rio::BaseVec3f &pInvDirection, f32 pMaxDistance, f32 *pDistance) const
+    {
+        f32 tx1 = (min.x - pOrigin.x) * pInvDirection.x;
+        f32 tx2 = (max.x - pOrigin.x) * pInvDirection.x;
+        f32 ty1 = (min.y - pOrigin.y) * pInvDirection.y;
+        f32 ty2 = (max.y - pOrigin.y) * pInvDirection.y;
+        f32 tz1 = (min.z - pOrigin.z) * pInvDirection.z;
+        f32 tz2 = (max.z - pOrigin.z) * pInvDirection.z;
+
+        f32 enter = std::max(std::max(std::min(tx1, tx2), std::min(ty1, ty2)), std::max(std::min(tz1, tz2), 0.f));
+        f32 exit = std::min(std::min(std::max(tx1, tx2), std::max(ty1, ty2)), std::min(std::max(tz1, tz2), pMaxDistance));
+
+        if (enter > exit)
+            return false;
+
+        *pDistance = enter;
+        return true;
+    }
+
+    // Box around this one after pMtx, without going through all eight corners: the new half size on every axis
+    // is the old one projected through the absolute values of the 3x3 part.
+    inline BoundingBox Transform(const rio::BaseMtx34f &pMtx) const
+    {
+        if (IsEmpty())
+            return *this;
+
+        const f32(*m)[4] = pMtx.m;
+        rio::Vector3f c = GetCenter();
+        rio::Vector3f h = GetHalfSize();
+
+        rio::Vector3f center = {
+            m[0][0] * c.x + m[0][1] * c.y + m[0][2] * c.z + m[0][3],
+            m[1][0] * c.x + m[1][1] * c.y + m[1][2] * c.z + m[1][3],
+            m[2][0] * c.x + m[2][1] * c.y + m[2][2] * c.z + m[2][3]};
+
+        rio::Vector3f halfSize = {
+            std::fabs(m[0][0]) * h.x + std::fabs(m[0][1]) * h.y + std::fabs(m[0][2]) * h.z,
+            std::fabs(m[1][0]) * h.x + std::fabs(m[1][1]) * h.y + std::fabs(m[1][2]) * h.z,
+            std::fabs(m[2][0]) * h.x + std::fabs(m[2][1]) * h.y + std::fabs(m[2][2]) * h.z};
+
+        return FromCenter(center, halfSize);
+    }
+};
+
+#endif // BOUNDINGBOXHELPER_H
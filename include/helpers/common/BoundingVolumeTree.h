@@ -0,0 +1,86 @@
+#ifndef BOUNDINGVOLUMETREEHELPER_H
+#define BOUNDINGVOLUMETREEHELPER_H
+
+#include <rio.h>
+#include <math/rio_Vector.h>
+#include <helpers/common/BoundingBox.h>
+#include <helpers/common/Frustum.h>
+#include <vector>
+
+// Dynamic AABB tree for finding things by where they are without walking all of them.
+// Every proxy is a leaf, inner nodes bound their two children. Leaves keep a box grown by a margin,
+// so small moves only replace the stored box and the tree itself is only touched once a proxy leaves its grown box.
+// Inserts pick the cheapest sibling by surface area and rotations keep the tree balanced.
+// Queries only read the tree, they can run on several threads at once as long as nothing changes it.
+class BoundingVolumeTree
+{
+public:
+    typedef u32 ProxyID;
+    static constexpr ProxyID cNullProxy = u32(-1);
+
+    struct RayHit
+    {
+        void *userData;
+        f32 distance;
+    };
+
+    explicit BoundingVolumeTree(f32 pMargin = 0.5f) : mMargin(pMargin) {};
+
+    // pBox must not be empty.
+    ProxyID Insert(const BoundingBox &pBox, void *pUserData);
+    void Remove(ProxyID pProxy);
+    // Returns true if the proxy had to be moved in the tree.
+    bool Update(ProxyID pProxy, const BoundingBox &pBox);
+    void Clear();
+
+    inline void *GetUserData(ProxyID pProxy) const { return mNodes[pProxy].userData; };
+    inline const BoundingBox &GetBounds(ProxyID pProxy) const { return mNodes[pProxy].box; };
+    inline u32 GetProxyCount() const { return mProxyCount; };
+    inline u32 GetHeight() const { return mRoot == cNullProxy ? 0 : mNodes[mRoot].height; };
+
+    // Results are appended to pOut. Proxies are tested with their own box, not the grown one.
+    void QueryFrustum(const Frustum &pFrustum, std::vector<void *> *pOut) const;
+    void QueryRadius(const rio::Vector3f &pCenter, f32 pRadius, std::vector<void *> *pOut) const;
+    // pDirection has to be normalized, hits are sorted nearest first.
+    void QueryRay(const rio::Vector3f &pOrigin, const rio::Vector3f &pDirection, f32 pMaxDistance, std::vector<RayHit> *pOut) const;
+
+private:
+    // A balanced tree of 2^32 leaves is still less than 64 levels high, the walk keeps at most one sibling per level.
+    static constexpr u32 cMaxStackSize = 128;
+
+    struct TreeNode
+    {
+        // Grown box for leaves, union of the children for inner nodes.
+        BoundingBox fatBox;
+        // Leaves only.
+        BoundingBox box;
+        void *userData = nullptr;
+        // Next free node while the node is unused.
+        u32 parent = cNullProxy;
+        u32 child1 = cNullProxy;
+        u32 child2 = cNullProxy;
+        // 0 for leaves, -1 while unused.
+        s32 height = -1;
+
+        inline bool IsLeaf() const { return child1 == cNullProxy; };
+    };
+
+    std::vector<TreeNode> mNodes;
+    u32 mRoot = cNullProxy;
+    u32 mFreeList = cNullProxy;
+    u32 mProxyCount = 0;
+    f32 mMargin;
+
+    u32 AllocateNode();
+    void FreeNode(u32 pNode);
+
+    void InsertLeaf(u32 pLeaf);
+    void RemoveLeaf(u32 pLeaf);
+    u32 FindBestSibling(const BoundingBox &pBox) const;
+    // Rotates pNode's subtree if its children differ in height by more than one, returns the new subtree root.
+    u32 Balance(u32 pNode);
+    // Refits boxes and heights from pNode up to the root, balancing on the way.
+    void Refit(u32 pNode);
+};
+
+#endif // BOUNDINGVOLUMETREEHELPER_H
@@ -3,9 +3,15 @@
 
 #include <stdio.h>
 #include <string>
+#include <list>
+#include <unordered_map>
+#include <helpers/common/MappedFile.h>
+#include <helpers/common/MiiHeadBatch.h>
 #include <nn/ffl.h>
 #include <filedevice/rio_FileDeviceMgr.h>
 
+class Shader;
+
 class FFLMgr
 {
 public:
@@ -17,20 +23,61 @@ public:
     void InitializeFFL();
     void CreateRandomMiddleDB(u16 pMiiLength);
 
-    FFLStoreData GetStoreDataFromFile(std::string fileName, rio::RawErrorCode *errCode);
+    // Safe to call from several threads at once. Returns false if the file is missing or too short.
+    bool GetStoreDataFromFile(const std::string &pFileName, FFLStoreData *pStoreData);
 
     FFLResolution GetGlobalResolution() { return mResolution; };
 
+    // Shared FFL shader for every Mii head. The first acquire compiles it, the last release deletes it.
+    Shader *AcquireShader();
+    void ReleaseShader();
+
+    // Mii heads with the same store data and expression share one batch, pModelMtx is added to it as an instance.
+    // Returns nullptr if FFL could not build the CharModel.
+    MiiHeadBatch *AcquireMiiHeadBatch(const FFLStoreData &pStoreData, u32 pExpressionFlag, const rio::BaseMtx34f *pModelMtx);
+    void ReleaseMiiHeadBatch(MiiHeadBatch *pBatch, const rio::BaseMtx34f *pModelMtx);
+
+    // Batches without instances keep their CharModel so the next acquire (or scene load) can reuse it.
+    // They are deleted least recently used first once the estimated size of all CharModels goes over the budget.
+    void SetCharModelCacheBudget(size_t pBytes);
+
+    inline size_t GetCharModelCacheBudget() const { return mCharModelCacheBudget; };
+    inline size_t GetCharModelCacheSize() const { return mCharModelCacheSize; };
+    inline u32 GetCharModelCacheHits() const { return mCharModelCacheHits; };
+    inline u32 GetCharModelCacheMisses() const { return mCharModelCacheMisses; };
+
+    // Rolls the per-frame shader stats over, call after the frame has been drawn.
+    void EndFrame();
+
     FFLMiddleDB mMiddleDB;
 
 private:
     static FFLMgr *mInstance;
     FFLResourceDesc mResourceDesc;
+    // FFL gets a writable pointer, so the resources are mapped copy-on-write.
+    MappedFile mResourceFiles[FFL_RESOURCE_TYPE_MAX];
     bool mInitialized;
 
     void *miiBufferSize;
 
     FFLResolution mResolution;
+
+    Shader *mpShader = nullptr;
+    u32 mShaderRefCount = 0;
+
+    typedef std::unordered_multimap<MiiHeadBatch::Key, MiiHeadBatch *, MiiHeadBatch::KeyHash> MiiHeadBatchMap;
+
+    MiiHeadBatchMap mMiiHeadBatches;
+    // Most recently released first.
+    std::list<MiiHeadBatch *> mUnusedMiiHeadBatches;
+
+    size_t mCharModelCacheBudget = 256 * 1024 * 1024;
+    size_t mCharModelCacheSize = 0;
+    u32 mCharModelCacheHits = 0;
+    u32 mCharModelCacheMisses = 0;
+
+    void EvictCharModels();
+    void DeleteMiiHeadBatch(MiiHeadBatch *pBatch);
 };
 
 #endif // FFLHELPER_H
\ No newline at end of file
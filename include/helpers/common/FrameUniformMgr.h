@@ -0,0 +1,115 @@
+#ifndef FRAMEUNIFORMHELPER_H
+#define FRAMEUNIFORMHELPER_H
+
+#include <rio.h>
+#include <math/rio_Matrix.h>
+#include <math/rio_Vector.h>
+#include <gpu/rio_UniformBlock.h>
+#include <helpers/common/Frustum.h>
+#include <helpers/common/UniformRing.h>
+
+class CameraProperty;
+
+// View and light data shared by every draw of a frame. NodeMgr updates it once the cameras have moved,
+// so the blocks are uploaded once per frame instead of once per mesh. Per-draw data goes through the draw ring.
+class FrameUniformMgr
+{
+public:
+    struct ViewBlock
+    {
+        rio::Vector3f view_pos;
+        u32 _padding;
+        rio::Matrix44f view_proj_mtx;
+    };
+
+    struct LightBlock
+    {
+        rio::Vector3f light_color;
+        u32 _padding_0;
+        rio::Vector3f light_pos;
+        u32 _padding_1;
+    };
+
+    // Objects drawn and objects skipped by frustum culling. Mii heads count one by one, meshes and primitives per property.
+    struct CullStats
+    {
+        u32 drawn;
+        u32 culled;
+    };
+
+    static bool createSingleton();
+    static bool destorySingleton();
+
+    static inline FrameUniformMgr *instance() { return mInstance; };
+
+    // Starts the frame of the draw ring, then reads the main camera, uploads both blocks, builds the culling frustum
+    // and hands the camera to the primitive renderer.
+    // Until a camera has started nothing is uploaded and IsValid() stays false.
+    void Update();
+    // Once every draw's uniforms are in the draw ring, before the first draw.
+    void FinishWrites();
+    // After the last draw of the frame.
+    void EndFrame();
+
+    inline bool IsValid() const { return mValid; };
+
+    // Same matrices the view block was built from, for shaders that take them as plain uniforms.
+    inline const rio::Matrix34f &GetViewMtx() const { return mViewMtx; };
+    inline const rio::Matrix44f &GetProjMtx() const { return mProjMtx; };
+    inline const rio::Vector3f &GetViewPos() const { return sViewBlock.view_pos; };
+
+    // Picked up by the next Update().
+    void SetLight(const rio::Vector3f &pColor, const rio::Vector3f &pPosition);
+
+    // Binds the shared blocks at the block indices of the shader about to draw. Nothing is uploaded here.
+    void BindViewBlock(u32 pVSIndex, u32 pFSIndex, rio::UniformBlock::ShaderStage pStage);
+    void BindLightBlock(u32 pVSIndex, u32 pFSIndex, rio::UniformBlock::ShaderStage pStage);
+
+    inline u32 GetFrameCount() const { return mFrameCount; };
+
+    // Frustum of the main camera this frame, nullptr while culling is off or there is no camera.
+    inline const Frustum *GetFrustum() const { return mValid && mCullingEnabled ? &mFrustum : nullptr; };
+    // True if the box can be seen this frame. Empty boxes are never culled, they mean the bounds aren't known.
+    inline bool IsVisible(const BoundingBox &pBox) const { return !GetFrustum() || pBox.IsEmpty() || mFrustum.IsVisible(pBox); };
+
+    inline void SetCullingEnabled(bool pEnabled) { mCullingEnabled = pEnabled; };
+    inline bool IsCullingEnabled() const { return mCullingEnabled; };
+
+    // Only from the GL thread, while drawing.
+    inline void AddDrawn(u32 pCount = 1) { mCullStats.drawn += pCount; };
+    inline void AddCulled(u32 pCount = 1) { mCullStats.culled += pCount; };
+    // Counts of the last finished frame.
+    inline const CullStats &GetCullStats() const { return mLastFrameCullStats; };
+
+    // Model matrices and other data that changes from draw to draw, written once per frame and bound by offset.
+    inline UniformRing &GetDrawRing() { return mDrawRing; };
+
+private:
+    static FrameUniformMgr *mInstance;
+
+    static ViewBlock sViewBlock;
+    static LightBlock sLightBlock;
+
+    rio::UniformBlock *mpViewUniformBlock = nullptr;
+    rio::UniformBlock *mpLightUniformBlock = nullptr;
+
+    UniformRing mDrawRing;
+
+    rio::Matrix34f mViewMtx;
+    rio::Matrix44f mProjMtx;
+
+    rio::Vector3f mLightColor = {1, 1, 1};
+    rio::Vector3f mLightPosition = {0, 0, 0};
+
+    bool mValid = false;
+    u32 mFrameCount = 0;
+
+    Frustum mFrustum;
+    bool mCullingEnabled = true;
+    CullStats mCullStats = {};
+    CullStats mLastFrameCullStats = {};
+
+    CameraProperty *FindMainCamera() const;
+};
+
+#endif // FRAMEUNIFORMHELPER_H
@@ -0,0 +1,30 @@
+#ifndef FRUSTUMHELPER_H
+#define FRUSTUMHELPER_H
+
+#include <rio.h>
+#include <math/rio_MathTypes.h>
+#include <math/rio_Vector.h>
+#include <helpers/common/BoundingBox.h>
+
+// The six planes of a view-projection matrix, for throwing out draws the camera can't see.
+// Tests are conservative: a box is only hidden if it is fully behind one plane.
+class Frustum
+{
+public:
+    void Set(const rio::BaseMtx44f &pViewProjMtx);
+
+    bool IsVisible(const BoundingBox &pBox) const;
+    bool IsVisible(const rio::Vector3f &pCenter, f32 pRadius) const;
+
+private:
+    // Points with dot(normal, point) + distance >= 0 are inside.
+    struct Plane
+    {
+        rio::Vector3f normal;
+        f32 distance;
+    };
+
+    Plane mPlanes[6];
+};
+
+#endif // FRUSTUMHELPER_H
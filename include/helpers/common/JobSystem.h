@@ -0,0 +1,75 @@
+#ifndef JOBSYSTEMHELPER_H
+#define JOBSYSTEMHELPER_H
+
+#include <rio.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Worker pool with one job deque per thread.
+// Threads push and pop their own jobs from the back of their deque, idle threads steal from the front of the others.
+// The thread that created the singleton acts as queue 0 and helps out with jobs while it waits.
+class JobSystem
+{
+public:
+    typedef std::function<void()> Job;
+
+    // Counts the jobs that are still in flight. Submit() increments it, every finished job decrements it.
+    typedef std::atomic<u32> JobCounter;
+
+    static bool createSingleton();
+    static bool destorySingleton();
+
+    static inline JobSystem *instance() { return mInstance; };
+
+    void Submit(Job pJob, JobCounter *pCounter);
+
+    // Runs queued jobs on the calling thread until the counter drops to zero.
+    void Wait(const JobCounter &pCounter);
+
+    // Splits [0, pCount) into batches of pBatchSize and calls pFunc(begin, end) for each of them in parallel. Blocks until all batches are done.
+    void ParallelFor(u32 pCount, u32 pBatchSize, const std::function<void(u32, u32)> &pFunc);
+
+    inline u32 GetWorkerCount() const { return mWorkers.size(); };
+
+private:
+    struct QueuedJob
+    {
+        Job job;
+        JobCounter *pCounter;
+    };
+
+    struct JobQueue
+    {
+        std::mutex mutex;
+        std::deque<QueuedJob> jobs;
+    };
+
+    static JobSystem *mInstance;
+    static thread_local u32 sQueueIndex;
+
+    void StartWorkers(u32 pWorkerCount);
+    void StopWorkers();
+    void WorkerMain(u32 pQueueIndex);
+
+    bool TryRunJob(u32 pQueueIndex);
+    bool PopJob(u32 pQueueIndex, QueuedJob &pJob);
+    bool StealJob(u32 pQueueIndex, QueuedJob &pJob);
+
+    std::vector<std::unique_ptr<JobQueue>> mQueues;
+    std::vector<std::thread> mWorkers;
+
+    std::atomic<bool> mRunning{false};
+    std::atomic<u32> mQueuedJobCount{0};
+
+    // Sleeping workers wait on this until new jobs get submitted.
+    std::mutex mWakeMutex;
+    std::condition_variable mWakeCondition;
+};
+
+#endif // JOBSYSTEMHELPER_H
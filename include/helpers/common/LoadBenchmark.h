@@ -0,0 +1,23 @@
+#ifndef LOADBENCHMARKHELPER_H
+#define LOADBENCHMARKHELPER_H
+
+#include <rio.h>
+#include <string>
+
+// Times NodeMgr::LoadFromFile() on generated maps of 1k, 10k and 100k nodes, in both formats,
+// once reading nodes one by one and once on the job system. Started with --benchmark-load instead of the main loop.
+class LoadBenchmark
+{
+public:
+    static void Run();
+
+private:
+    // Writes a map of pNodeCount nodes to the map folder, every node has a Primitive and an ExampleEnum property
+    // and every fourth one is parented to the node before it.
+    static bool WriteMap(const std::string &pFileName, u32 pNodeCount, bool pBinary);
+
+    // Best of a few loads, in milliseconds. Negative if the map couldn't be loaded.
+    static f32 TimeLoad(const std::string &pFileName, bool pParallel);
+};
+
+#endif // LOADBENCHMARKHELPER_H
@@ -0,0 +1,59 @@
+#ifndef MAPPEDFILEHELPER_H
+#define MAPPEDFILEHELPER_H
+
+#include <rio.h>
+#include <atomic>
+#include <cstddef>
+#include <string>
+
+// Whole file on the native file system as one view. Desktop builds map the file, so pages are only read once touched
+// and nothing is copied to the heap. On Cafe the file is loaded into a buffer through the native file device instead.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // pAlignment is the alignment of the data pointer, 0 for the page size.
+    // With pCopyOnWrite the view can be written to, written pages become private copies and never reach the file.
+    bool Open(const std::string &pPath, u32 pAlignment = 0, bool pCopyOnWrite = false);
+    void Close();
+
+    inline bool IsOpen() const { return mpData != nullptr; };
+    inline bool IsMapped() const { return mMapped; };
+
+    inline const u8 *GetData() const { return mpData; };
+    // Only for views opened with pCopyOnWrite.
+    inline u8 *GetWritableData() const { return mCopyOnWrite ? mpData : nullptr; };
+    inline size_t GetSize() const { return mSize; };
+
+    inline f32 GetLoadTimeMs() const { return mLoadTimeMs; };
+
+    // Bytes of the view currently in physical memory. Loaded buffers are always fully resident,
+    // on Windows mappings report their whole size.
+    size_t GetResidentSize() const;
+
+    // Size of every view open right now.
+    static inline size_t GetTotalSize() { return sTotalSize; };
+
+private:
+    u8 *mpData = nullptr;
+    size_t mSize = 0;
+    bool mMapped = false;
+    bool mCopyOnWrite = false;
+    f32 mLoadTimeMs = 0.f;
+
+    // Start and size of the whole mapping, which can begin before mpData when it had to be aligned.
+    void *mpMapping = nullptr;
+    size_t mMappingSize = 0;
+
+    static std::atomic<size_t> sTotalSize;
+
+    bool Map(const std::string &pPath, u32 pAlignment);
+    bool Load(const std::string &pPath, u32 pAlignment);
+};
+
+#endif // MAPPEDFILEHELPER_H
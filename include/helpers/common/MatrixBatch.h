@@ -0,0 +1,56 @@
+#ifndef MATRIXBATCHHELPER_H
+#define MATRIXBATCHHELPER_H
+
+#include <rio.h>
+#include <math/rio_MathTypes.h>
+#include <cstddef>
+
+// Matrix math over many 3x4 matrices at once. Batches are loaded into registers one matrix element per vector,
+// so each lane works on its own matrix: 8 at a time with AVX, 4 with SSE2 or NEON, leftovers and other targets go through
+// the scalar version of the same code. Every lane does the same operations in the same order as the scalar math in rio,
+// so results only differ where the compiler fuses multiply-adds in the scalar code.
+class MatrixBatch
+{
+public:
+    // Where the matrices of a batch are: either every pStride bytes from pBase, so they can sit inside bigger structs,
+    // or one pointer per matrix. Used for inputs and outputs alike.
+    class Stream
+    {
+    public:
+        Stream(const rio::BaseMtx34f *pBase, size_t pStride = sizeof(rio::BaseMtx34f))
+            : mpBase(reinterpret_cast<const u8 *>(pBase)), mStride(pStride), mpPointers(nullptr) {};
+        Stream(const rio::BaseMtx34f *const *pPointers)
+            : mpBase(nullptr), mStride(0), mpPointers(pPointers) {};
+
+        inline rio::BaseMtx34f *Get(u32 pIndex) const
+        {
+            const rio::BaseMtx34f *mtx = mpPointers ? mpPointers[pIndex] : reinterpret_cast<const rio::BaseMtx34f *>(mpBase + pIndex * mStride);
+            return const_cast<rio::BaseMtx34f *>(mtx);
+        };
+
+    private:
+        const u8 *mpBase;
+        size_t mStride;
+        const rio::BaseMtx34f *const *mpPointers;
+    };
+
+    // Name of the instruction set the batches run on.
+    static const char *GetInstructionSet();
+
+    // pOut[i] = pLeft * pRight[i], view times model for example.
+    static void Mul(const rio::BaseMtx34f &pLeft, const Stream &pRight, const Stream &pOut, u32 pCount);
+    // pOut[i] = pLeft[i] * pRight[i], parent world times local for example.
+    static void Mul(const Stream &pLeft, const Stream &pRight, const Stream &pOut, u32 pCount);
+
+    // Normal matrices: inverse transpose of the upper 3x3, translation cleared. Singular matrices come out as zero.
+    static void InverseTranspose(const Stream &pIn, const Stream &pOut, u32 pCount);
+
+    // Normalizes the first column, then rebuilds the other two from it and the second one (Gram-Schmidt).
+    // Only the upper 3x3 is written.
+    static void Orthonormalize(const Stream &pInOut, u32 pCount);
+
+    // Modelview and its orthonormalized inverse transpose per model in one pass, what the FFL shader takes as u_mv and u_it.
+    static void ViewNormal(const rio::BaseMtx34f &pView, const Stream &pModel, const Stream &pModelView, const Stream &pNormal, u32 pCount);
+};
+
+#endif // MATRIXBATCHHELPER_H
@@ -0,0 +1,30 @@
+#ifndef MATRIXBENCHMARKHELPER_H
+#define MATRIXBENCHMARKHELPER_H
+
+#include <rio.h>
+#include <math/rio_Matrix.h>
+#include <vector>
+
+// Times MatrixBatch against the scalar code it replaced on 1k, 10k and 100k generated transforms:
+// parent times local world matrices, normal matrices and the Mii modelview plus normal matrix.
+// Started with --benchmark-matrix instead of the main loop.
+class MatrixBenchmark
+{
+public:
+    static void Run();
+
+private:
+    typedef std::vector<rio::Matrix34f> MatrixList;
+
+    // SRT matrices from a fixed seed, so every run works on the same data.
+    static void MakeMatrices(MatrixList *pOut, u32 pCount, u32 pSeed);
+
+    // Largest difference between two lists, element by element.
+    static f32 GetMaxDifference(const MatrixList &pA, const MatrixList &pB);
+
+    // Best of a few runs of pFunc, in milliseconds.
+    template <typename Func>
+    static f32 Time(Func pFunc);
+};
+
+#endif // MATRIXBENCHMARKHELPER_H
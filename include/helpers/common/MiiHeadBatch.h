@@ -0,0 +1,112 @@
+#ifndef MIIHEADBATCHHELPER_H
+#define MIIHEADBATCHHELPER_H
+
+#include <rio.h>
+#include <math/rio_MathTypes.h>
+#include <math/rio_Matrix.h>
+#include <nn/ffl.h>
+#include <Shader.h>
+#include <helpers/common/BoundingBox.h>
+#include <helpers/common/Frustum.h>
+#include <cstddef>
+#include <vector>
+
+// One CharModel shared by every Mii head with the same store data and expression.
+// Instances are the model matrices of the heads using it, read again every time the batch is drawn.
+// The first instance draws the whole batch, on GL with one instanced draw per shape. Instances outside the frustum are left out.
+class MiiHeadBatch
+{
+public:
+    // Everything a CharModel is built from. The store data is only kept as a hash, Matches() compares the bytes.
+    struct Key
+    {
+        u64 storeDataHash;
+        u32 resolution;
+        u32 expressionFlag;
+        u32 resourceType;
+        u32 modelFlag;
+
+        bool operator==(const Key &pOther) const
+        {
+            return storeDataHash == pOther.storeDataHash && resolution == pOther.resolution && expressionFlag == pOther.expressionFlag &&
+                   resourceType == pOther.resourceType && modelFlag == pOther.modelFlag;
+        }
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key &pKey) const;
+    };
+
+    static Key MakeKey(const FFLStoreData &pStoreData, const FFLCharModelDesc &pDesc);
+
+    MiiHeadBatch(const FFLStoreData &pStoreData, const FFLCharModelDesc &pDesc);
+    ~MiiHeadBatch();
+
+    // Runs the CPU and GPU steps of the CharModel, false if FFL could not build it.
+    bool Initialize(Shader *pShader);
+
+    bool Matches(const FFLStoreData &pStoreData) const;
+
+    inline const Key &GetKey() const { return mKey; };
+
+    // Estimate of the memory FFL allocated for the CharModel, mostly its textures.
+    size_t GetMemorySize() const;
+
+    void AddInstance(const rio::BaseMtx34f *pModelMtx);
+    void RemoveInstance(const rio::BaseMtx34f *pModelMtx);
+
+    inline u32 GetInstanceCount() const { return mInstances.size(); };
+    inline bool IsLeader(const rio::BaseMtx34f *pModelMtx) const { return !mInstances.empty() && mInstances[0] == pModelMtx; };
+
+    // Culls the instances against pFrustum first, nullptr draws all of them. The translucent pass draws the same ones.
+    void DrawOpa(const rio::BaseMtx34f &pViewMtx, const rio::BaseMtx44f &pProjMtx, const Frustum *pFrustum);
+    void DrawXlu(const rio::BaseMtx34f &pViewMtx, const rio::BaseMtx44f &pProjMtx);
+
+    // Instances that passed culling in the last DrawOpa().
+    inline u32 GetVisibleInstanceCount() const { return mVisibleInstances.size(); };
+
+    inline const BoundingBox &GetBounds() const { return mBounds; };
+
+    inline const Shader *GetShader() const { return mpShader; };
+    inline f32 GetCPUStepTimeMs() const { return mCPUStepTimeMs; };
+    inline f32 GetGPUStepTimeMs() const { return mGPUStepTimeMs; };
+
+private:
+    Key mKey;
+    FFLStoreData mStoreData;
+    FFLCharModel mCharModel;
+    FFLCharModelDesc mCharModelDesc;
+    FFLCharModelSource mCharModelSource;
+    bool mInitialized = false;
+
+    Shader *mpShader = nullptr;
+    std::vector<const rio::BaseMtx34f *> mInstances;
+
+    // Bounds of the CharModel in FFL units, the instance matrices take them to world space.
+    BoundingBox mBounds;
+
+    // Built for every visible instance in one batch with the opaque draw and reused by the translucent one.
+    std::vector<const rio::BaseMtx34f *> mVisibleInstances;
+    std::vector<rio::Matrix34f> mModelViewMtx;
+    std::vector<rio::Matrix34f> mNormalMtx;
+
+    void UpdateInstanceMatrices(const rio::BaseMtx34f &pViewMtx, const Frustum *pFrustum);
+
+#if RIO_IS_WIN
+    // Instance data is uploaded with the opaque draw and reused by the translucent one.
+    std::vector<Shader::InstanceData> mInstanceData;
+    u32 mInstanceVBOHandle = 0;
+
+    void UpdateInstanceBuffer();
+#endif
+
+    f32 mCPUStepTimeMs = 0.f;
+    f32 mGPUStepTimeMs = 0.f;
+
+    void BindShader(u32 pInstance, const rio::BaseMtx44f &pProjMtx);
+    void DrawOpaPass();
+    void DrawXluPass();
+};
+
+#endif // MIIHEADBATCHHELPER_H
@@ -6,71 +6,108 @@
 #include <vector>
 #include <memory>
 #include <string>
+#include <array>
+#include <helpers/common/TransformStore.h>
+#include <helpers/common/BoundingVolumeTree.h>
 #include <helpers/properties/Property.h>
+#include <helpers/properties/PropertyTypes.h>
 
 class Property;
 
 class Node
 {
 public:
-    rio::Matrix34f transformMatrix;
     std::vector<std::unique_ptr<Property>> properties;
     std::string nodeKey;
     int ID;
 
-    virtual ~Node() { properties.clear(); };
+    virtual ~Node();
     Node(std::string pNodeKey, rio::Vector3f pPos, rio::Vector3f pRot, rio::Vector3f pScale);
 
-    inline rio::Vector3f GetScale() { return mScale; };
-    inline rio::Vector3f GetPosition() { return mPosition; };
-    inline rio::Vector3f GetRotation() { return mRotation; };
+    // Transform data lives in NodeMgr's TransformStore, Node is only a view over it.
+    inline rio::Vector3f GetScale() { return mpTransformStore->GetScale(mTransformHandle); };
+    inline rio::Vector3f GetPosition() { return mpTransformStore->GetPosition(mTransformHandle); };
+    inline rio::Vector3f GetRotation() { return mpTransformStore->GetRotation(mTransformHandle); };
 
-    inline void SetScale(rio::Vector3f pScale)
+    // The returned reference is only valid until nodes are added or removed.
+    inline const rio::Matrix34f &GetWorldMatrix() { return mpTransformStore->GetWorldMatrix(mTransformHandle); };
+    inline u32 GetWorldMatrixVersion() { return mpTransformStore->GetWorldMatrixVersion(mTransformHandle); };
+
+    inline rio::Vector3f GetWorldPosition()
     {
-        mScale = pScale;
-        return UpdateMatrix();
+        const rio::Matrix34f &worldMatrix = GetWorldMatrix();
+        return {worldMatrix.m[0][3], worldMatrix.m[1][3], worldMatrix.m[2][3]};
     };
 
+    inline void SetScale(rio::Vector3f pScale)
+    {
+        if (mpTransformStore->SetScale(mTransformHandle, pScale))
+            MarkSaveDirty();
+    };
     inline void SetPosition(rio::Vector3f pPos)
     {
-        mPosition = pPos;
-        return UpdateMatrix();
+        if (mpTransformStore->SetPosition(mTransformHandle, pPos))
+            MarkSaveDirty();
     };
-
     inline void SetRotation(rio::Vector3f pRot)
     {
-        mRotation = pRot;
-        return UpdateMatrix();
+        if (mpTransformStore->SetRotation(mTransformHandle, pRot))
+            MarkSaveDirty();
     };
 
+    inline TransformStore::Handle GetTransformHandle() const { return mTransformHandle; };
+
+    // Union of the bounds of every started property, or a small box around the world position if none of them has any.
+    BoundingBox GetWorldBounds();
+    // Moves and resizes follow the world matrix on their own. This is for bounds that change without it,
+    // so NodeMgr refits the node in its spatial index after this frame's UpdateAsync().
+    void MarkBoundsDirty();
+
+    // Once parented, position, rotation and scale are relative to the parent node.
+    // Returns false if pParent is this node or one of its children. Pass nullptr to unparent.
+    bool SetParent(std::shared_ptr<Node> pParent);
+    inline std::shared_ptr<Node> GetParent() const { return mParent.lock(); };
+
     void CreateNodeProperties();
 
     bool isEditorSelected = false;
 
+    // Set when the name, parent or transform change, so the next save emits this node again.
+    // Property changes are tracked on the properties themselves.
+    inline void MarkSaveDirty() { mSaveDirty = true; };
+    bool IsSaveDirty() const;
+
     bool AddProperty(std::unique_ptr<Property> pProperty);
 
+    // Returns every property of type T on this node, in the order they were added. No RTTI, no allocation.
     template <typename T>
-    std::vector<T *> GetProperty()
+    inline PropertySpan<T> GetProperty() const
     {
-        std::vector<T *> result;
-
-        for (const auto &property : properties)
-        {
-            if (T *propertyFound = dynamic_cast<T *>(property.get()))
-            {
-                result.push_back(propertyFound);
-            }
-        }
-
-        return result;
+        const std::vector<Property *> &typed = mPropertiesByType[T::cPropertyType];
+        return PropertySpan<T>(typed.data(), typed.size());
     }
 
 private:
-    rio::Vector3f mPosition;
-    rio::Vector3f mRotation;
-    rio::Vector3f mScale;
-
-    inline void UpdateMatrix() { transformMatrix.makeSRT(mScale, mRotation, mPosition); };
+    TransformStore *mpTransformStore;
+    TransformStore::Handle mTransformHandle;
+    std::weak_ptr<Node> mParent;
+
+    // Per-type index over properties.
+    std::array<std::vector<Property *>, PROPERTY_TYPE_MAX> mPropertiesByType;
+
+    // Set while the node is part of NodeMgr, so its properties show up in the scene-wide type registry.
+    friend class NodeMgr;
+    bool mRegisteredInNodeMgr = false;
+
+    // Leaf of the node in NodeMgr's spatial index, and whether it is waiting to be refit there.
+    BoundingVolumeTree::ProxyID mSpatialProxy = BoundingVolumeTree::cNullProxy;
+    bool mSpatialDirty = false;
+
+    // YAML of this node from the last save, already indented to sit under "nodes", and the parent ID written into it (0 for none).
+    // A parent can go away without this node hearing about it, the fragment is only reused while the ID still matches.
+    std::string mSaveFragment;
+    int mSaveParentID = 0;
+    bool mSaveDirty = true;
 };
 
 #endif // COMMONHELPER_H
\ No newline at end of file
@@ -4,10 +4,18 @@
 #include <rio.h>
 #include <math/rio_Matrix.h>
 #include <helpers/common/Node.h>
+#include <helpers/common/TransformStore.h>
+#include <helpers/common/BoundingVolumeTree.h>
+#include <helpers/common/SceneFile.h>
+#include <helpers/common/MappedFile.h>
 #include <vector>
 #include <memory>
 #include <string>
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <thread>
 #include <unordered_map>
 #include <functional>
 
@@ -27,22 +35,94 @@ public:
     static int AddNode(std::shared_ptr<Node> pNode);
     static bool DeleteNode(const int pIndex);
 
-    bool LoadFromFile(std::string fileName);
+    enum SceneFormat
+    {
+        SCENE_FORMAT_YAML,
+        SCENE_FORMAT_BINARY
+    };
+
+    // Takes either format, binary maps are told apart by their header.
+    // Unless pParallel is false, transforms and properties are read on the job system. Node IDs and order don't change.
+    bool LoadFromFile(std::string fileName, bool pParallel = true);
+
+    // Creates the nodes and starts their properties over the next frames instead, see SetStreamingBudget().
+    // No Start() call needed. Properties are updated and drawn once they are initialized.
+    bool LoadFromFileStreaming(std::string fileName);
+
+    inline bool IsStreaming() const { return mpStreamingLoad != nullptr; };
+    f32 GetStreamingProgress() const;
+
+    // Time a streaming load may take per frame. At least one node or one batch of properties is done every frame.
+    inline void SetStreamingBudget(f32 pBudgetMs) { mStreamingBudgetMs = pBudgetMs; };
+    inline f32 GetStreamingBudget() const { return mStreamingBudgetMs; };
+
+    // Saves in the format the map was loaded in.
     bool SaveToFile();
+    // Saving in the other format writes next to the loaded map, with the extension of that format.
+    bool SaveToFile(SceneFormat pFormat);
+
+    // Snapshots the scene at the start of the next Update() and writes it on a background thread.
+    // Requests made while a save is running are coalesced into one more save once it is done.
+    void SaveToFileAsync();
+    void SaveToFileAsync(SceneFormat pFormat);
+
+    inline bool IsSaving() const { return mpSaveSnapshot != nullptr || mSaveRequested; };
+    // Share of the nodes the running save has written so far, from 0 to 1.
+    f32 GetSaveProgress() const;
+
+    inline u32 GetSaveCount() const { return mSaveCount; };
+    inline bool GetLastSaveResult() const { return mLastSaveResult; };
+    inline f32 GetLastSaveTimeMs() const { return mLastSaveTimeMs; };
 
     std::vector<std::shared_ptr<Node>> mNodes;
 
     static inline NodeMgr *instance() { return mInstance; };
     static inline int GetNodeCount() { return mInstance ? mInstance->mNodes.size() : 0; };
-    static inline void ClearAllNodes() { return mInstance->mNodes.clear(); };
+    static void ClearAllNodes();
 
     void Update();
     void Start();
 
     std::shared_ptr<Node> GetNodeByKey(const char *pKey);
     Node *GetNodeByID(const int ID);
+
+    // IDs only ever go up, so a deleted node's ID is never handed out again while parent links in saves refer to IDs.
+    inline int AcquireNodeID() { return mNextNodeID++; };
     Node *GetNodeByIndex(const int pIndex);
 
+    inline TransformStore &GetTransformStore() { return mTransformStore; };
+
+    // Keeps the key index in sync after a node has been renamed.
+    void OnNodeKeyChanged(Node *pNode, const std::string &pOldKey);
+    // Queues the node for a refit in the spatial index, see Node::MarkBoundsDirty().
+    void OnNodeBoundsChanged(Node *pNode);
+
+    struct NodeHit
+    {
+        Node *node;
+        f32 distance;
+    };
+
+    // Finds nodes by their world bounds as of the last Update(), without walking every node. Results are appended to pOut.
+    void QueryNodesInFrustum(const Frustum &pFrustum, std::vector<Node *> *pOut) const;
+    void QueryNodesInRadius(const rio::Vector3f &pCenter, f32 pRadius, std::vector<Node *> *pOut) const;
+    // pDirection has to be normalized, hits are sorted nearest first.
+    void QueryNodesOnRay(const rio::Vector3f &pOrigin, const rio::Vector3f &pDirection, f32 pMaxDistance, std::vector<NodeHit> *pOut) const;
+
+    inline const BoundingVolumeTree &GetSpatialIndex() const { return mSpatialIndex; };
+
+    // Returns every property of type T across the scene as one contiguous list, in the order they were added.
+    template <typename T>
+    inline PropertySpan<T> GetProperties() const
+    {
+        const std::vector<Property *> &typed = mPropertiesByType[T::cPropertyType];
+        return PropertySpan<T>(typed.data(), typed.size());
+    }
+
+    // Keeps the per-type registry in sync, called by Node when properties are added or the node is destroyed.
+    void RegisterProperty(Property *pProperty);
+    void UnregisterProperties(Node *pNode);
+
     using PropertyCreateFunc = std::function<std::unique_ptr<Property>(std::shared_ptr<Node>)>;
     std::unordered_map<std::string, PropertyCreateFunc> mPropertyFactory = {
         {"Audio", [](std::shared_ptr<Node> node)
@@ -61,6 +141,142 @@ public:
 private:
     static NodeMgr *mInstance;
     std::string currentFilePath = "/";
+    SceneFormat mCurrentFileFormat = SCENE_FORMAT_YAML;
+
+    // A map on its way to becoming nodes. Kept across frames by streaming loads.
+    struct SceneLoad
+    {
+        MappedFile file;
+        bool binary = false;
+        SceneFile::View view;
+        YAML::Node nodesYaml;
+        YAML::const_iterator nextYamlNode;
+
+        u32 nodeCount = 0;
+        u32 createdCount = 0;
+        std::vector<std::weak_ptr<Node>> createdNodes;
+
+        // Per node, filled in by CreateNodeShell() and ReadNode().
+        std::vector<YAML::Node> nodeYamls;
+        std::vector<int> fileIDs;
+        std::vector<int> parentIDs;
+        std::vector<u8> hasParent;
+        // Set while nodes are read on several threads at once.
+        bool parallel = false;
+
+        std::unordered_map<int, std::shared_ptr<Node>> loadedNodes;
+        std::vector<std::pair<std::shared_ptr<Node>, int>> pendingParents;
+        bool nodesFinished = false;
+
+        struct PendingStart
+        {
+            std::weak_ptr<Node> node;
+            Property *property;
+        };
+
+        std::vector<PendingStart> startQueue;
+        u32 startedCount = 0;
+
+        u32 frameCount = 0;
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    };
+
+    std::unique_ptr<SceneLoad> mpStreamingLoad;
+    f32 mStreamingBudgetMs = 4.f;
+
+    std::unique_ptr<SceneLoad> OpenScene(const std::string &fileName);
+    // Returns false once every node has been created.
+    bool CreateNextNode(SceneLoad *pLoad);
+    void LoadNodesParallel(SceneLoad *pLoad);
+    std::shared_ptr<Node> CreateNodeShell(SceneLoad *pLoad, u32 pIndex);
+    void ReadNode(SceneLoad *pLoad, u32 pIndex, const std::shared_ptr<Node> &pNode);
+    void AddLoadedNode(SceneLoad *pLoad, u32 pIndex, const std::shared_ptr<Node> &pNode);
+    void FinishNodes(SceneLoad *pLoad);
+    void UpdateStreaming();
+
+    // Everything a save writes, copied from the scene on the main thread so it can be written from any thread.
+    struct SaveSnapshot
+    {
+        struct NodeEntry
+        {
+            std::weak_ptr<Node> node;
+            int id;
+            std::string name;
+            bool hasParent;
+            int parentId;
+            rio::Vector3f position;
+            rio::Vector3f rotation;
+            rio::Vector3f scale;
+
+            // YAML saves only serialize nodes that changed since the last save, the rest reuse their fragment from then.
+            bool serialize;
+            std::vector<YAML::Node> properties;
+            std::string fragment;
+        };
+
+        SceneFormat format;
+        std::string filePath;
+        std::vector<NodeEntry> nodes;
+
+        std::atomic<u32> writtenCount{0};
+        u32 serializedCount = 0;
+        bool result = false;
+        f32 timeMs = 0.f;
+    };
+
+    std::unique_ptr<SaveSnapshot> mpSaveSnapshot;
+    std::thread mSaveThread;
+    std::atomic<bool> mSaveThreadDone{false};
+
+    bool mSaveRequested = false;
+    SceneFormat mRequestedSaveFormat = SCENE_FORMAT_YAML;
+
+    u32 mSaveCount = 0;
+    bool mLastSaveResult = false;
+    f32 mLastSaveTimeMs = 0.f;
+
+    std::string GetSavePath(SceneFormat pFormat) const;
+    void TakeSnapshot(SaveSnapshot *pSnapshot, SceneFormat pFormat);
+    static void WriteSnapshot(SaveSnapshot *pSnapshot);
+    static void EmitNodeYaml(YAML::Emitter &pOut, const SaveSnapshot::NodeEntry &pEntry);
+    void FinishSnapshot(SaveSnapshot *pSnapshot);
+
+    // Finishes a save whose thread is done and starts a requested one, called once per frame.
+    void UpdateSave();
+    // Blocks until the running save is done.
+    void WaitForSave();
+
+    // Shared by both formats, pPropertyNode is the property body without its name.
+    void CreateProperty(const std::shared_ptr<Node> &pNode, const std::string &pPropertyName, const YAML::Node &pPropertyNode);
+
+    TransformStore mTransformStore;
+
+    // Lookup indexes over mNodes. Each bucket keeps its nodes in the order they were added,
+    // so duplicate keys/IDs still resolve to the earliest added node.
+    std::unordered_map<std::string, std::vector<std::shared_ptr<Node>>> mNodeKeyIndex;
+    std::unordered_map<int, std::vector<std::shared_ptr<Node>>> mNodeIDIndex;
+    // Above every ID in the scene, including ones assigned from outside AcquireNodeID().
+    int mNextNodeID = 1;
+
+    void IndexNode(const std::shared_ptr<Node> &pNode);
+    void UnindexNode(const std::shared_ptr<Node> &pNode);
+
+    // Every node in mNodes is a proxy here. Moved nodes are refit once per frame, after UpdateAsync() has updated their bounds.
+    BoundingVolumeTree mSpatialIndex;
+    // Indexed by transform handle, to get from TransformStore's changed handles to the nodes.
+    std::vector<Node *> mNodesByHandle;
+    std::vector<Node *> mSpatialDirtyNodes;
+
+    void AddToSpatialIndex(Node *pNode);
+    void RemoveFromSpatialIndex(Node *pNode);
+    void UpdateSpatialIndex();
+
+    // Properties of every node in mNodes, grouped by type.
+    std::array<std::vector<Property *>, PROPERTY_TYPE_MAX> mPropertiesByType;
+
+    void RegisterProperties(Node *pNode);
+    void UpdateProperties(PropertyType pType);
+    void UpdatePropertiesAsync();
 
     bool mInitialized = false;
 };
@@ -0,0 +1,124 @@
+#ifndef SCENEFILEHELPER_H
+#define SCENEFILEHELPER_H
+
+#include <rio.h>
+#include <math/rio_Vector.h>
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <yaml-cpp/yaml.h>
+
+// Binary counterpart of the YAML maps. Fixed-layout records in native byte order, so a mapped file is read in place:
+// header, node records, property records, string table, then the property blobs.
+// Properties only know how to load from YAML, so each blob holds the YAML of one property body.
+class SceneFile
+{
+public:
+    static const u16 cVersion = 1;
+    static const u16 cByteOrderMark = 0xFEFF;
+    static const char cMagic[4];
+    static const char cExtension[];
+
+    enum NodeFlag
+    {
+        NODE_FLAG_HAS_PARENT = 1 << 0
+    };
+
+    struct Header
+    {
+        char magic[4];
+        u16 byteOrder;
+        u16 version;
+        u32 fileSize;
+        u32 nodeCount;
+        u32 nodeOffset;
+        u32 propertyCount;
+        u32 propertyOffset;
+        u32 stringTableOffset;
+        u32 stringTableSize;
+        u32 blobOffset;
+        u32 blobSize;
+    };
+
+    struct NodeRecord
+    {
+        s32 id;
+        s32 parentId;
+        u32 flags;
+        // Offset into the string table, strings are null terminated.
+        u32 nameOffset;
+        f32 position[3];
+        f32 rotation[3];
+        f32 scale[3];
+        // Properties of a node are stored next to each other.
+        u32 firstProperty;
+        u32 propertyCount;
+    };
+
+    struct PropertyRecord
+    {
+        u32 nameOffset;
+        // Offset into the blob section. Blobs are null terminated too, the size does not count it.
+        u32 blobOffset;
+        u32 blobSize;
+    };
+
+    // Read-only view over a binary scene somewhere in memory. Nothing is copied, the data has to outlive the view.
+    class View
+    {
+    public:
+        // Checks the header and that every section lies inside the data, false if the data can't be read.
+        bool Initialize(const u8 *pData, size_t pSize);
+
+        inline u32 GetNodeCount() const { return mpHeader->nodeCount; };
+        inline const NodeRecord &GetNode(u32 pIndex) const { return mpNodes[pIndex]; };
+        inline const PropertyRecord &GetProperty(u32 pIndex) const { return mpProperties[pIndex]; };
+
+        inline const char *GetString(u32 pOffset) const { return mpStrings + pOffset; };
+        inline const char *GetBlob(const PropertyRecord &pProperty) const { return mpBlobs + pProperty.blobOffset; };
+
+    private:
+        const Header *mpHeader = nullptr;
+        const NodeRecord *mpNodes = nullptr;
+        const PropertyRecord *mpProperties = nullptr;
+        const char *mpStrings = nullptr;
+        const char *mpBlobs = nullptr;
+    };
+
+    // Collects records in file order and lays them out. Repeated strings are only stored once.
+    class Builder
+    {
+    public:
+        void AddNode(s32 pID, const std::string &pName, bool pHasParent, s32 pParentID, const rio::Vector3f &pPosition, const rio::Vector3f &pRotation, const rio::Vector3f &pScale);
+
+        // Added to the last node. pData is the YAML of the property body, without the property name.
+        void AddProperty(const std::string &pName, const std::string &pData);
+
+        void Build(std::vector<u8> *pOut) const;
+
+    private:
+        std::vector<NodeRecord> mNodes;
+        std::vector<PropertyRecord> mProperties;
+        std::string mStrings;
+        std::string mBlobs;
+        std::unordered_map<std::string, u32> mStringOffsets;
+
+        u32 AddString(const std::string &pString);
+    };
+
+    static bool IsBinary(const u8 *pData, size_t pSize);
+
+    // Transforms are written the same way by NodeMgr and the converter.
+    static void EmitYamlTransform(YAML::Emitter &pOut, const rio::Vector3f &pPosition, const rio::Vector3f &pRotation, const rio::Vector3f &pScale);
+
+    static bool ConvertYamlToBinary(const YAML::Node &pYaml, std::vector<u8> *pOut);
+    static void ConvertBinaryToYaml(const View &pView, YAML::Emitter &pOut);
+
+    // Reads a map in either format from pSrcPath and writes it in the other one to pDstPath. Both are native paths.
+    static bool ConvertFile(const std::string &pSrcPath, const std::string &pDstPath);
+
+    static bool WriteFile(const std::string &pPath, const void *pData, size_t pSize);
+};
+
+#endif // SCENEFILEHELPER_H
@@ -0,0 +1,123 @@
+#ifndef TRANSFORMSTOREHELPER_H
+#define TRANSFORMSTOREHELPER_H
+
+#include <rio.h>
+#include <math/rio_Matrix.h>
+#include <math/rio_Vector.h>
+#include <vector>
+
+// Structure-of-arrays storage for node transforms.
+// Nodes only keep a stable handle, the transform data itself is packed densely
+// so per-frame matrix work walks contiguous memory instead of chasing node pointers.
+// Setters only flag the transform as dirty, world matrices are rebuilt lazily (at most once per change).
+// Transforms can be parented to each other, positions/rotations/scales are then relative to the parent.
+class TransformStore
+{
+public:
+    typedef u32 Handle;
+    static constexpr Handle cInvalidHandle = u32(-1);
+
+    Handle Create(const rio::Vector3f &pPos, const rio::Vector3f &pRot, const rio::Vector3f &pScale);
+    void Destroy(Handle pHandle);
+
+    inline bool IsValid(Handle pHandle) const { return pHandle < mHandleToIndex.size() && mHandleToIndex[pHandle] != cInvalidIndex; };
+    inline u32 GetCount() const { return mPositions.size(); };
+
+    inline const rio::Vector3f &GetPosition(Handle pHandle) const { return mPositions[mHandleToIndex[pHandle]]; };
+    inline const rio::Vector3f &GetRotation(Handle pHandle) const { return mRotations[mHandleToIndex[pHandle]]; };
+    inline const rio::Vector3f &GetScale(Handle pHandle) const { return mScales[mHandleToIndex[pHandle]]; };
+
+    // Rebuilds the world matrix first if the transform (or one of its parents) changed since it was last built.
+    inline const rio::Matrix34f &GetWorldMatrix(Handle pHandle)
+    {
+        u32 index = mHandleToIndex[pHandle];
+        ResolveWorldMatrix(index);
+
+        return mWorldMatrices[index];
+    };
+
+    // Bumped every time the world matrix is rebuilt, lets users skip work for unchanged transforms.
+    inline u32 GetWorldMatrixVersion(Handle pHandle)
+    {
+        u32 index = mHandleToIndex[pHandle];
+        ResolveWorldMatrix(index);
+
+        return mWorldVersions[index];
+    };
+
+    // Returns false if the new parent would create a cycle. Passing cInvalidHandle detaches the transform.
+    bool SetParent(Handle pHandle, Handle pParent);
+    inline Handle GetParent(Handle pHandle) const { return mParents[mHandleToIndex[pHandle]]; };
+    inline const std::vector<Handle> &GetChildren(Handle pHandle) const { return mChildren[pHandle]; };
+
+    // Return false if the value was already set.
+    bool SetPosition(Handle pHandle, const rio::Vector3f &pPos);
+    bool SetRotation(Handle pHandle, const rio::Vector3f &pRot);
+    bool SetScale(Handle pHandle, const rio::Vector3f &pScale);
+
+    // Walks the transforms one hierarchy level at a time and rebuilds only the dirty subtrees,
+    // the parent multiplies of a level go through MatrixBatch together. Returns the number of rebuilt matrices.
+    u32 UpdateWorldMatrices();
+
+    // Every transform whose world matrix got rebuilt since the last ClearChangedHandles(), in UpdateWorldMatrices()
+    // or on demand. A handle can be in here more than once, and handles destroyed since are not taken out.
+    inline const std::vector<Handle> &GetChangedHandles() const { return mChangedHandles; };
+    inline void ClearChangedHandles() { mChangedHandles.clear(); };
+
+    // Dense arrays, all of them are GetCount() long and share the same ordering.
+    // World matrices are only up to date after UpdateWorldMatrices().
+    inline const rio::Vector3f *GetPositions() const { return mPositions.data(); };
+    inline const rio::Vector3f *GetRotations() const { return mRotations.data(); };
+    inline const rio::Vector3f *GetScales() const { return mScales.data(); };
+    inline const rio::Matrix34f *GetWorldMatrices() const { return mWorldMatrices.data(); };
+
+private:
+    static constexpr u32 cInvalidIndex = u32(-1);
+
+    void UpdateWorldMatrix(u32 pIndex);
+    void ResolveWorldMatrix(u32 pIndex);
+    void RebuildOrder();
+
+    // A world matrix is stale when its local transform changed or its parent got rebuilt since.
+    inline bool IsWorldMatrixStale(u32 pIndex, u32 pParentIndex) const
+    {
+        if (mDirty[pIndex])
+            return true;
+
+        return pParentIndex != cInvalidIndex && mParentVersions[pIndex] != mWorldVersions[pParentIndex];
+    };
+
+    inline u32 GetParentIndex(u32 pIndex) const { return mParents[pIndex] == cInvalidHandle ? cInvalidIndex : mHandleToIndex[mParents[pIndex]]; };
+
+    static inline bool IsEqual(const rio::Vector3f &pA, const rio::Vector3f &pB) { return pA.x == pB.x && pA.y == pB.y && pA.z == pB.z; };
+
+    std::vector<rio::Vector3f> mPositions;
+    std::vector<rio::Vector3f> mRotations;
+    std::vector<rio::Vector3f> mScales;
+    std::vector<rio::Matrix34f> mWorldMatrices;
+    std::vector<u32> mWorldVersions;
+    std::vector<u8> mDirty;
+
+    // Hierarchy. mParentVersions holds the parent world version the world matrix was built against.
+    std::vector<Handle> mParents;
+    std::vector<u32> mParentVersions;
+    std::vector<std::vector<Handle>> mChildren; // Indexed by handle
+    std::vector<u32> mOrder;                    // Dense indices, breadth first so parents always come before their children
+    std::vector<u32> mLevelStarts;              // Where each hierarchy level starts in mOrder, plus its end
+    bool mOrderDirty = false;
+
+    // Scratch for the batched multiplies of one level, kept around so updates don't allocate.
+    std::vector<rio::Matrix34f> mBatchLocals;
+    std::vector<const rio::BaseMtx34f *> mBatchParents;
+    std::vector<rio::BaseMtx34f *> mBatchWorlds;
+    std::vector<u32> mBatchIndices;
+
+    std::vector<Handle> mChangedHandles;
+
+    // Handle <-> dense index mapping. Handles stay valid while the dense arrays get compacted.
+    std::vector<Handle> mIndexToHandle;
+    std::vector<u32> mHandleToIndex;
+    std::vector<Handle> mFreeHandles;
+};
+
+#endif // TRANSFORMSTOREHELPER_H
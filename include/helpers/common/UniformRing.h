@@ -0,0 +1,94 @@
+#ifndef UNIFORMRINGHELPER_H
+#define UNIFORMRINGHELPER_H
+
+#include <rio.h>
+#include <gpu/rio_Shader.h>
+#include <atomic>
+
+#if RIO_IS_WIN
+#include <array>
+#endif // RIO_IS_WIN
+
+// Per-draw uniform data for a whole frame, streamed through one buffer that stays mapped.
+// The buffer is split in cRegionCount regions and every frame writes to the next one. On GL a fence per region
+// makes sure the GPU is done reading a region before it is written again, so nothing is orphaned or re-allocated.
+// Persistent mappings need GL 4.5 or ARB_buffer_storage and ARB_direct_state_access. Without them (macOS stops at 4.1)
+// only the frame's region is mapped, from BeginFrame() to FinishWrites().
+class UniformRing
+{
+public:
+    static const u32 cRegionCount = 3;
+
+    // Binding point of the streamed block on GL, kept away from rio's own and from the FFL shader's.
+    static const u32 cBinding = 13;
+
+    UniformRing() = default;
+    ~UniformRing();
+
+    UniformRing(const UniformRing &) = delete;
+    UniformRing &operator=(const UniformRing &) = delete;
+
+    bool Initialize(u32 pRegionSize);
+
+    // Waits for the GPU to be done with the region this frame writes to. Grows the ring first if the last frame ran out of space,
+    // unless growing failed before.
+    void BeginFrame();
+    // Called once nothing writes to this frame's region anymore, before the first draw reading from it.
+    void FinishWrites();
+    // Called after the last draw reading from this frame's region.
+    void EndFrame();
+
+    // Size of one entry of pSize bytes, entries start on the uniform buffer offset alignment.
+    u32 GetStride(u32 pSize) const;
+
+    // Reserves pCount consecutive entries of pSize bytes in this frame's region, safe to call from several threads.
+    // Returns where the first one is written to and its offset, or nullptr if the region is full.
+    u8 *Allocate(u32 pCount, u32 pSize, u32 *pOffset);
+
+    // On GL every shader reading pBlockName has to be pointed at cBinding once. Nothing to do on Cafe.
+    static void AttachShader(const rio::Shader *pShader, const char *pBlockName);
+
+    // Binds pSize bytes at pOffset as the block at pVSIndex and pFSIndex, u32(-1) for stages that don't read it.
+    // The indices are only needed on Cafe, GL uses cBinding.
+    void Bind(u32 pOffset, u32 pSize, u32 pVSIndex, u32 pFSIndex) const;
+
+    inline u32 GetRegionSize() const { return mRegionSize; };
+    // Bytes written during the last finished frame.
+    inline u32 GetLastFrameSize() const { return mLastFrameSize; };
+    // Frames that had to wait on the GPU before writing, and entries that didn't fit.
+    inline u32 GetWaitCount() const { return mWaitCount; };
+    inline u32 GetOverflowCount() const { return mOverflowCount; };
+
+private:
+    u8 *mpData = nullptr;
+    // This frame's region while it can be written to, nullptr otherwise.
+    u8 *mpRegionData = nullptr;
+    u32 mRegionSize = 0;
+    u32 mAlignment = 0;
+
+    u32 mRegion = 0;
+    std::atomic<u32> mUsed{0};
+    // Set by Allocate(), which can run on any thread.
+    std::atomic<bool> mOverflowed{false};
+    std::atomic<u32> mOverflowCount{0};
+
+    u32 mLastFrameSize = 0;
+    u32 mWaitCount = 0;
+    bool mGrowFailed = false;
+
+#if RIO_IS_WIN
+    u32 mHandle = 0;
+    // False when the buffer can't stay mapped, mpData is unused then.
+    bool mPersistent = false;
+    std::array<GLsync, cRegionCount> mFences = {};
+#endif // RIO_IS_WIN
+
+    bool CreateBuffer(u32 pRegionSize);
+    void DestroyBuffer();
+    // Only once nothing in flight reads from the buffer anymore.
+    void Grow();
+
+    inline u32 GetRegionStart() const { return mRegion * mRegionSize; };
+};
+
+#endif // UNIFORMRINGHELPER_H
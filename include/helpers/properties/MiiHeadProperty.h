@@ -9,6 +9,7 @@
 #include <helpers/editor/EditorTypes.h>
 
 class Shader;
+class MiiHeadBatch;
 
 class MiiHeadProperty : public Property
 {
@@ -68,55 +69,55 @@ public:
     typedef InitArg<FFLStoreData> InitArgStoreData;
     typedef InitArg<FFLMiddleDB> InitArgMiddleDB;
 
+    PROPERTY_TYPE(PROPERTY_TYPE_MII_HEAD);
     using Property::Property;
     ~MiiHeadProperty();
 
+    void StartAsync() override;
     void Start() override;
+    void UpdateAsync() override;
     void Update() override;
+    void DrawXlu() override;
     void CreatePropertiesMenu() override;
 
+    BoundingBox GetWorldBounds() const override;
+
     void Load(YAML::Node node) override;
     YAML::Node Save() override;
 
-    void SetExpression(FFLExpressionFlag pExpressionFlag)
-    {
-        mCharModelDesc.expressionFlag = pExpressionFlag;
-        FFLInitCharModelCPUStep(&mCharModel, &mCharModelSource, &mCharModelDesc);
-        FFLInitCharModelGPUStep(&mCharModel);
-    };
-
-    void SetStoreData(FFLStoreData pStoreData)
-    {
-        mCharModelSource.pBuffer = &pStoreData;
-        FFLInitCharModelCPUStep(&mCharModel, &mCharModelSource, &mCharModelDesc);
-        FFLInitCharModelGPUStep(&mCharModel);
-
-        GetAdditionalData();
-    };
+    void SetExpression(FFLExpressionFlag pExpressionFlag);
+    void SetStoreData(FFLStoreData pStoreData);
 
-    FFLExpressionFlag GetExpression() { return (FFLExpressionFlag)(mCharModelDesc.expressionFlag); };
+    FFLExpressionFlag GetExpression() { return (FFLExpressionFlag)(mExpressionFlag); };
     FFLStoreData GetStoreData() { return mStoreData; };
     std::string GetMiiName() { return mMiiName; };
 
 private:
     std::string mMiiDataFile = "";
 
-    FFLStoreData mStoreData;
-    FFLCharModel mCharModel;
-    FFLCharModelDesc mCharModelDesc;
-    FFLCharModelSource mCharModelSource;
+    FFLStoreData mStoreData = {};
+    // False until store data was read or set, heads without it never acquire a batch.
+    bool mStoreDataValid = false;
+    u32 mExpressionFlag = FFL_EXPRESSION_FLAG_NORMAL;
     FFLAdditionalInfo mAdditionalInfo;
 
     std::string mMiiName = "";
 
-    Shader mShader;
-    const Shader *mpShader;
+    // CharModel shared with every other Mii head showing the same Mii and expression.
+    MiiHeadBatch *mpBatch = nullptr;
+
+    // Load timings in milliseconds, split by phase.
+    f32 mLoadTimeMs = 0.f;
+    f32 mCPUStepTimeMs = 0.f;
+    f32 mGPUStepTimeMs = 0.f;
 
-    CameraProperty *mainCameraProperty;
+    // Node world matrix scaled down to FFL units, only rebuilt when the node moves.
+    rio::Mtx34f mNodeMtx;
+    u32 mNodeMtxVersion = 0;
 
     void LoadStoreData();
-    void DrawOpa();
-    void DrawXlu();
+    void UpdateNodeMatrix();
+    void AcquireBatch();
     void GetAdditionalData();
 };
 
@@ -2,6 +2,8 @@
 #define COMMONPROPERTYHELPER_H
 
 #include <helpers/common/Node.h>
+#include <helpers/common/BoundingBox.h>
+#include <helpers/properties/PropertyTypes.h>
 #include <yaml-cpp/yaml.h>
 
 class Node;
@@ -12,25 +14,53 @@ public:
     Property(std::shared_ptr<Node> pParentNode) : parentNode(pParentNode) {};
     virtual ~Property() = default;
 
+    // Called once before Start(), possibly on a worker thread and in parallel with other properties.
+    // Meant for file reads and decoding: no GL calls, no writes to nodes or other properties.
+    virtual void StartAsync() {};
+
     virtual void Start() = 0;
     virtual void Update() = 0;
+
+    // Called every frame before Update(), possibly on a worker thread and in parallel with other properties.
+    // Only for CPU work on the property's own data: no GL calls, no writes to nodes or other properties.
+    // World matrices are already up to date at this point.
+    virtual void UpdateAsync() {};
+
+    // Called every frame after every property's Update(), for draws that need blending over the opaque scene.
+    virtual void DrawXlu() {};
+
+    // World space box around what the property draws, empty if there is nothing to bound yet.
+    // Read by NodeMgr on the main thread once every UpdateAsync() of the frame is done.
+    virtual BoundingBox GetWorldBounds() const { return BoundingBox(); };
     virtual void CreatePropertiesMenu() = 0;
 
     virtual YAML::Node Save() = 0;
+    // Possibly called on a worker thread and in parallel with other properties, before the node is part of the scene.
+    // Only reads node and fills in the property's own members.
     virtual void Load(YAML::Node node) = 0;
 
+    // Overridden through PROPERTY_TYPE() in every property class.
+    virtual PropertyType GetPropertyType() const { return PROPERTY_TYPE_UNKNOWN; };
+
     inline std::weak_ptr<Node> GetParentNode() const { return parentNode; };
     inline int GetPropertyID() const { return propertyId; };
 
     inline void SetPropertyID(int pPropertyId) { propertyId = pPropertyId; };
     inline void SetLoggingString(std::string pLoggingString) { loggingString = pLoggingString; };
 
+    // Set when something Save() writes changes, so the next save emits the node again.
+    // The editor marks a property whenever one of its widgets was edited.
+    inline void MarkDirty() { mDirty = true; };
+    inline void ClearDirty() { mDirty = false; };
+    inline bool IsDirty() const { return mDirty; };
+
     bool mInitialized = false;
 
 private:
     std::string loggingString = "PROPERTY";
     std::weak_ptr<Node> parentNode;
     int propertyId = 0;
+    bool mDirty = true;
 };
 
 #endif // COMMONPROPERTYHELPER_H
\ No newline at end of file
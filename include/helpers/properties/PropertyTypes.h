@@ -0,0 +1,76 @@
+#ifndef PROPERTYTYPES_H
+#define PROPERTYTYPES_H
+
+#include <cstddef>
+#include <stdexcept>
+
+class Property;
+
+// Compile-time property type IDs. Every property class declares its own with PROPERTY_TYPE(),
+// so typed lookups can go through a per-type index instead of dynamic_cast.
+enum PropertyType
+{
+    PROPERTY_TYPE_UNKNOWN = 0,
+    PROPERTY_TYPE_AUDIO,
+    PROPERTY_TYPE_CAMERA,
+    PROPERTY_TYPE_PRIMITIVE,
+    PROPERTY_TYPE_MESH,
+    PROPERTY_TYPE_MII_HEAD,
+    PROPERTY_TYPE_EXAMPLE,
+    PROPERTY_TYPE_EXAMPLE_ENUM,
+    PROPERTY_TYPE_MAX
+};
+
+// Put inside the public section of a property class.
+#define PROPERTY_TYPE(pType)                                      \
+    static constexpr PropertyType cPropertyType = pType;          \
+    inline PropertyType GetPropertyType() const override { return cPropertyType; }
+
+// Non-owning view over a contiguous list of properties that all share the type T.
+// Only valid until a property of that type is added or removed.
+template <typename T>
+class PropertySpan
+{
+public:
+    class Iterator
+    {
+    public:
+        Iterator(Property *const *pCurrent) : mpCurrent(pCurrent) {};
+
+        inline T *operator*() const { return static_cast<T *>(*mpCurrent); };
+        inline Iterator &operator++()
+        {
+            ++mpCurrent;
+            return *this;
+        };
+        inline bool operator!=(const Iterator &pOther) const { return mpCurrent != pOther.mpCurrent; };
+
+    private:
+        Property *const *mpCurrent;
+    };
+
+    PropertySpan() = default;
+    PropertySpan(Property *const *pData, size_t pSize) : mpData(pData), mSize(pSize) {};
+
+    inline size_t size() const { return mSize; };
+    inline bool empty() const { return mSize == 0; };
+
+    inline T *operator[](size_t pIndex) const { return static_cast<T *>(mpData[pIndex]); };
+
+    inline T *at(size_t pIndex) const
+    {
+        if (pIndex >= mSize)
+            throw std::out_of_range("PropertySpan::at");
+
+        return static_cast<T *>(mpData[pIndex]);
+    };
+
+    inline Iterator begin() const { return Iterator(mpData); };
+    inline Iterator end() const { return Iterator(mpData + mSize); };
+
+private:
+    Property *const *mpData = nullptr;
+    size_t mSize = 0;
+};
+
+#endif // PROPERTYTYPES_H
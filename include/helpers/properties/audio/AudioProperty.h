@@ -24,6 +24,7 @@ public:
         f32 volume = 1.f;
     };
 
+    PROPERTY_TYPE(PROPERTY_TYPE_AUDIO);
     using Property::Property;
 
     void Load(YAML::Node node) override;
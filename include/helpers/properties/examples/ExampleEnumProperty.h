@@ -21,6 +21,7 @@ public:
         {"Example 0", EXAMPLE_ENUM_0},
         {"Example 1", EXAMPLE_ENUM_1}};
 
+    PROPERTY_TYPE(PROPERTY_TYPE_EXAMPLE_ENUM);
     using Property::Property;
 
     // Called when the task is loading from YAML. Used for loading values into members of your property class.
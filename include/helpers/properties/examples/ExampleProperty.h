@@ -5,6 +5,8 @@ class ExampleProperty : public Property
 public:
     // All class members here will be accessible from any other properties within the task.
 
+    // Every property needs its own entry in PropertyType (see PropertyTypes.h).
+    PROPERTY_TYPE(PROPERTY_TYPE_EXAMPLE);
     using Property::Property;
 
     // Called when the task is loading from YAML. Used for loading values into members of your property class.
@@ -3,6 +3,7 @@
 
 #include <helpers/properties/Property.h>
 #include <helpers/properties/map/CameraProperty.h>
+#include <helpers/common/BoundingBox.h>
 #include <gfx/mdl/rio_Material.h>
 #include <gfx/mdl/rio_Mesh.h>
 #include <gfx/mdl/res/rio_ModelCacher.h>
@@ -15,30 +16,16 @@
 class MeshProperty : public Property
 {
 public:
-    struct ViewBlock
-    {
-        rio::Vector3f view_pos;
-        u32 _padding;
-        rio::Matrix44f view_proj_mtx;
-    };
-
-    struct LightBlock
-    {
-        rio::Vector3f light_color;
-        u32 _padding_0;
-        rio::Vector3f light_pos;
-        u32 _padding_1;
-    };
-
+    // Written to the draw ring every frame, entries are padded to the uniform offset alignment there.
     struct ModelBlock
     {
         rio::Matrix34f model_mtx;
         rio::Matrix34f normal_mtx;
-        rio::BaseVec4u _padding[10];
     };
 
 public:
     // All class members here will be accessible from any other properties within the task.
+    PROPERTY_TYPE(PROPERTY_TYPE_MESH);
     MeshProperty(std::shared_ptr<Node> pParentNode) : Property(pParentNode), mMdlModel(nullptr) {};
 
     ~MeshProperty();
@@ -51,9 +38,14 @@ public:
     // Called when task starts. Used for initializing values, and preparing for rendering or controlling.
     void Start() override;
 
+    // Called every frame, off the GL thread. Rebuilds the mesh matrices and bounds, and culls the model.
+    void UpdateAsync() override;
+
     // Called every frame.
     void Update() override;
 
+    inline BoundingBox GetWorldBounds() const override { return mWorldBounds; };
+
     // Editor function. Do not use within normal gameplay.
     // Called when a task is saving. Used for saving values into a YAML node.
     YAML::Node Save() override;
@@ -62,8 +54,6 @@ public:
     // Called when a property is selected within the editor. Used for creating ImGui UI to change default property values.
     void CreatePropertiesMenu() override;
 
-    static ViewBlock sViewBlock;
-    static LightBlock sLightBlock;
     std::unique_ptr<rio::mdl::Model> mMdlModel;
 
 private:
@@ -102,30 +92,41 @@ private:
     struct UniformBlocks
     {
         UniformBlocks()
-            : view_block_idx(), light_block_idx()
+            : view_block_idx(), light_block_idx(), model_block_idx()
         {
         }
 
-        UniformBlocks(const ShaderLocation &in_view_block_idx, const ShaderLocation &in_light_block_idx)
-            : view_block_idx{in_view_block_idx}, light_block_idx{in_light_block_idx}
+        UniformBlocks(const ShaderLocation &in_view_block_idx, const ShaderLocation &in_light_block_idx, const ShaderLocation &in_model_block_idx)
+            : view_block_idx{in_view_block_idx}, light_block_idx{in_light_block_idx}, model_block_idx{in_model_block_idx}
         {
         }
 
         ShaderLocation view_block_idx;
         ShaderLocation light_block_idx;
+        ShaderLocation model_block_idx;
     };
 
     // Private class members for use within your property.
     std::string mMeshFileName;
     std::string mMeshKey;
 
-    CameraProperty *mCameraProperty;
+    // Version of the node world matrix last pushed to mMdlModel.
+    u32 mWorldMtxVersion = 0;
+
+    // View and light blocks are shared by every mesh, see FrameUniformMgr.
+    UniformBlocks *mUniformBlocks = nullptr;
+
+    // Where UpdateAsync() put this frame's model blocks in the draw ring, one entry per mesh.
+    u32 mModelBlockOffset = 0;
+    u32 mModelBlockFrame = u32(-1);
+
+    // Bounds of every mesh from its vertices, in the space of the mesh, and of the whole model in world space.
+    std::vector<BoundingBox> mMeshBounds;
+    BoundingBox mWorldBounds;
+    // Hidden models get no model blocks and skip their draw.
+    bool mVisible = true;
 
-    rio::UniformBlock *mModelUniformBlock;
-    ModelBlock *mModelBlock;
-    UniformBlocks *mUniformBlocks;
-    rio::UniformBlock *mpViewUniformBlock;
-    rio::UniformBlock *mpLightUniformBlock;
+    void UpdateWorldBounds();
 };
 
 #endif // MESHPROPERTY_H
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define PRIMITIVEPROPERTY_H
 
 #include <helpers/properties/Property.h>
+#include <helpers/common/BoundingBox.h>
 #include <gfx/rio_Color.h>
 
 class PrimitiveProperty : public Property
@@ -15,6 +16,7 @@ public:
         SHAPE_TYPE_CYLINDER = 3
     };
 
+    PROPERTY_TYPE(PROPERTY_TYPE_PRIMITIVE);
     using Property::Property;
 
     void Load(YAML::Node node);
@@ -24,10 +26,14 @@ public:
     void Start() override;
     void CreatePropertiesMenu() override;
 
+    BoundingBox GetWorldBounds() const override;
+
 private:
     ShapeType mShapeType;
     f32 mShapeRadius;
     rio::Color4f mShapeColor;
+
+    BoundingBox GetWorldBounds(const rio::Vector3f &pWorldPosition, const rio::Vector3f &pScale) const;
 };
 
 #endif // PRIMITIVEPROPERTY_H
\ No newline at end of file
@@ -29,6 +29,7 @@ public:
         rio::Color4f pClearColor = {0.2f, 0.3f, 0.3f, 0.0f};
     };
 
+    PROPERTY_TYPE(PROPERTY_TYPE_CAMERA);
     using Property::Property;
 
     void Load(YAML::Node node);
@@ -28,8 +28,8 @@ void RootTask::prepare_()
 
     EditorMgr::instance()->SetupFrameBuffer();
     FFLMgr::instance()->InitializeFFL();
-    NodeMgr::instance()->LoadFromFile("testMap.yaml");
-    NodeMgr::instance()->Start();
+    // Nodes show up over the first frames instead of holding the window until everything is started.
+    NodeMgr::instance()->LoadFromFileStreaming("testMap.yaml");
 
     mInitialized = true;
 }
@@ -41,6 +41,7 @@ void RootTask::calc_()
 
     EditorMgr::instance()->Update();
     NodeMgr::instance()->Update();
+    FFLMgr::instance()->EndFrame();
     EditorMgr::instance()->CreateEditorUI();
 }
 
@@ -3,8 +3,13 @@
 #include <gpu/rio_RenderState.h>
 #include <math/rio_Matrix.h>
 #include <misc/rio_MemUtil.h>
+#include <helpers/common/MatrixBatch.h>
 #include <helpers/common/NodeMgr.h>
 
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
 #if RIO_IS_CAFE
 #include <gx2/registers.h>
 #include <gx2/utils.h>
@@ -52,84 +57,59 @@ namespace
         p_attribute->endianSwap = GX2_ENDIAN_SWAP_DEFAULT;
     }
 
-#endif // RIO_IS_CAFE
+#elif RIO_IS_WIN
 
-    const rio::BaseVec4f &getColorUniform(const FFLColor &color)
+    struct AttributeFormat
     {
-        return reinterpret_cast<const rio::BaseVec4f &>(color.r);
-    }
+        s32 count;
+        u32 type;
+        bool normalized;
+    };
+
+    // Indexed by FFLAttributeBufferType.
+    const AttributeFormat cAttributeFormat[FFL_ATTRIBUTE_BUFFER_TYPE_MAX] = {
+        {3, GL_FLOAT, false},                // Position
+        {2, GL_FLOAT, false},                // TexCoord
+        {4, GL_INT_2_10_10_10_REV, true},    // Normal
+        {4, GL_BYTE, true},                  // Tangent
+        {4, GL_UNSIGNED_BYTE, true}};        // Color
 
-    void safeNormalizeVec3(rio::BaseVec3f *vec)
+    // std140 layouts of the uniform blocks in FFLShader.frag.
+    struct LightBlock
     {
-        float magnitude = std::sqrt(vec->x * vec->x + vec->y * vec->y + vec->z * vec->z);
-        if (magnitude != 0.0f)
-        {
-            vec->x /= magnitude;
-            vec->y /= magnitude;
-            vec->z /= magnitude;
-        }
+        FFLColor ambient;
+        FFLColor diffuse;
+        FFLColor specular;
+        rio::BaseVec3f dir;
+        f32 _pad0;
+        FFLColor rimColor;
+        f32 rimPower;
+        f32 _pad1[3];
+    };
 
-        vec->x = std::fmax(std::fmin(vec->x, 1.0f), -1.0f);
-        vec->y = std::fmax(std::fmin(vec->y, 1.0f), -1.0f);
-        vec->z = std::fmax(std::fmin(vec->z, 1.0f), -1.0f);
+    struct MaterialBlock
+    {
+        FFLColor ambient;
+        FFLColor diffuse;
+        FFLColor specular;
+        s32 specularMode;
+        f32 specularPower;
+        f32 _pad[2];
+    };
 
-        if (vec->x == 1.0f || vec->x == -1.0f)
-        {
-            vec->y = 0.0f;
-            vec->z = 0.0f;
-        }
-        else if (vec->y == 1.0f || vec->y == -1.0f)
-        {
-            vec->x = 0.0f;
-            vec->z = 0.0f;
-        }
-        else if (vec->z == 1.0f || vec->z == -1.0f)
-        {
-            vec->x = 0.0f;
-            vec->y = 0.0f;
-        }
-    }
+    // Kept away from the low binding points rio uses for its own uniform blocks.
+    const u32 cLightBlockBinding = 14;
+    const u32 cMaterialBlockBinding = 15;
 
-    void gramSchmidtOrthonormalizeMtx34(rio::BaseMtx34f *mat)
+    // a_instance_mv and a_instance_it in FFLShader.vert, one location per column.
+    const u32 cInstanceAttribLocation = 5;
+    const u32 cInstanceNormalAttribLocation = 9;
+
+#endif // RIO_IS_CAFE
+
+    const rio::BaseVec4f &getColorUniform(const FFLColor &color)
     {
-        rio::BaseVec3f c0, c0Normalized, c1, c1Normalized, c1New, c2New;
-
-        // Extract and normalize the first column
-        c0.x = mat->m[0][0];
-        c0.y = mat->m[1][0];
-        c0.z = mat->m[2][0];
-        c0Normalized = c0;
-        safeNormalizeVec3(&c0Normalized);
-
-        // Extract and normalize the second column
-        c1.x = mat->m[0][1];
-        c1.y = mat->m[1][1];
-        c1.z = mat->m[2][1];
-        c1Normalized = c1;
-        safeNormalizeVec3(&c1Normalized);
-
-        // Compute the third column as the cross product of the first two normalized columns
-        c2New.x = c0Normalized.y * c1Normalized.z - c0Normalized.z * c1Normalized.y;
-        c2New.y = c0Normalized.z * c1Normalized.x - c0Normalized.x * c1Normalized.z;
-        c2New.z = c0Normalized.x * c1Normalized.y - c0Normalized.y * c1Normalized.x;
-
-        // Compute the new second column as the cross product of the third column and the first normalized column
-        c1New.x = c2New.y * c0Normalized.z - c2New.z * c0Normalized.y;
-        c1New.y = c2New.z * c0Normalized.x - c2New.x * c0Normalized.z;
-        c1New.z = c2New.x * c0Normalized.y - c2New.y * c0Normalized.x;
-
-        // Update the matrix with the new orthonormal columns
-        mat->m[0][0] = c0Normalized.x;
-        mat->m[1][0] = c0Normalized.y;
-        mat->m[2][0] = c0Normalized.z;
-
-        mat->m[0][1] = c1New.x;
-        mat->m[1][1] = c1New.y;
-        mat->m[2][1] = c1New.z;
-
-        mat->m[0][2] = c2New.x;
-        mat->m[1][2] = c2New.y;
-        mat->m[2][2] = c2New.z;
+        return reinterpret_cast<const rio::BaseVec4f &>(color.r);
     }
 
     struct FFLiDefaultShaderMaterial
@@ -231,11 +211,16 @@ Shader::Shader()
 #if RIO_IS_CAFE
     : mAttribute(), mFetchShader()
 #elif RIO_IS_WIN
-    : mVBOHandle(), mVAOHandle()
+    : mVAOHandle(), mLightUBOHandle(), mMaterialUBOHandle(), mMaterialUBOStride(), mBoundMaterial(-1), mInstanceVBOHandle(), mInstanceCount(), mDrawBuffers(), mScratchBuffer()
 #endif
+    , mInstanced(false)
+    , mpCharModel(nullptr)
 {
     rio::MemUtil::set(mVertexUniformLocation, u8(-1), sizeof(mVertexUniformLocation));
     rio::MemUtil::set(mPixelUniformLocation, u8(-1), sizeof(mPixelUniformLocation));
+    rio::MemUtil::set(mPixelUniformValue, 0, sizeof(mPixelUniformValue));
+    rio::MemUtil::set(&mUniformStats, 0, sizeof(mUniformStats));
+    rio::MemUtil::set(&mLastFrameUniformStats, 0, sizeof(mLastFrameUniformStats));
     mSamplerLocation = -1;
     rio::MemUtil::set(mAttributeLocation, u8(-1), sizeof(mAttributeLocation));
 }
@@ -249,16 +234,75 @@ Shader::~Shader()
         mFetchShader.program = nullptr;
     }
 #elif RIO_IS_WIN
+    for (auto &entry : mDrawBuffers)
+        destroyDrawBuffer_(&entry.second);
+    mDrawBuffers.clear();
+    destroyDrawBuffer_(&mScratchBuffer);
+
+    if (mLightUBOHandle != GL_NONE)
+    {
+        RIO_GL_CALL(glDeleteBuffers(1, &mLightUBOHandle));
+        mLightUBOHandle = GL_NONE;
+    }
+
+    if (mMaterialUBOHandle != GL_NONE)
+    {
+        RIO_GL_CALL(glDeleteBuffers(1, &mMaterialUBOHandle));
+        mMaterialUBOHandle = GL_NONE;
+    }
+
     if (mVAOHandle != GL_NONE)
     {
         RIO_GL_CALL(glDeleteVertexArrays(1, &mVAOHandle));
-        RIO_GL_CALL(glDeleteBuffers(FFL_ATTRIBUTE_BUFFER_TYPE_MAX, mVBOHandle));
-        rio::MemUtil::set(mVBOHandle, 0, sizeof(mVBOHandle));
         mVAOHandle = GL_NONE;
     }
 #endif
 }
 
+void Shader::endFrame()
+{
+    mLastFrameUniformStats = mUniformStats;
+    rio::MemUtil::set(&mUniformStats, 0, sizeof(mUniformStats));
+}
+
+template <typename T>
+void Shader::setPixelUniform_(u32 uniform, const T &value) const
+{
+    static_assert(sizeof(T) <= sizeof(UniformValue::data), "Uniform value does not fit the cache");
+
+    s32 location = mPixelUniformLocation[uniform];
+    if (location == -1)
+        return;
+
+    UniformValue &cached = mPixelUniformValue[uniform];
+    if (cached.valid && std::memcmp(cached.data, &value, sizeof(T)) == 0)
+    {
+        mUniformStats.skipped++;
+        return;
+    }
+
+    mShader.setUniform(value, u32(-1), u32(location));
+
+    std::memcpy(cached.data, &value, sizeof(T));
+    cached.valid = true;
+    mUniformStats.issued++;
+}
+
+void Shader::invalidateUniformCache_() const
+{
+    for (u32 i = 0; i < PIXEL_UNIFORM_MAX; i++)
+        mPixelUniformValue[i].valid = false;
+}
+
+void Shader::setInstanced_(bool instanced) const
+{
+    if (mVertexUniformLocation[VERTEX_UNIFORM_INSTANCED] == -1 || instanced == mInstanced)
+        return;
+
+    mShader.setUniform(instanced, mVertexUniformLocation[VERTEX_UNIFORM_INSTANCED], u32(-1));
+    mInstanced = instanced;
+}
+
 void Shader::initialize()
 {
     mShader.load("FFLShader", rio::Shader::MODE_UNIFORM_REGISTER);
@@ -266,6 +310,9 @@ void Shader::initialize()
     mVertexUniformLocation[VERTEX_UNIFORM_IT] = mShader.getVertexUniformLocation("u_it");
     mVertexUniformLocation[VERTEX_UNIFORM_MV] = mShader.getVertexUniformLocation("u_mv");
     mVertexUniformLocation[VERTEX_UNIFORM_PROJ] = mShader.getVertexUniformLocation("u_proj");
+#if RIO_IS_WIN
+    mVertexUniformLocation[VERTEX_UNIFORM_INSTANCED] = mShader.getVertexUniformLocation("u_instanced");
+#endif
 
     mPixelUniformLocation[PIXEL_UNIFORM_CONST1] = mShader.getFragmentUniformLocation("u_const1");
     mPixelUniformLocation[PIXEL_UNIFORM_CONST2] = mShader.getFragmentUniformLocation("u_const2");
@@ -283,6 +330,10 @@ void Shader::initialize()
     mPixelUniformLocation[PIXEL_UNIFORM_MODE] = mShader.getFragmentUniformLocation("u_mode");
     mPixelUniformLocation[PIXEL_UNIFORM_RIM_COLOR] = mShader.getFragmentUniformLocation("u_rim_color");
     mPixelUniformLocation[PIXEL_UNIFORM_RIM_POWER] = mShader.getFragmentUniformLocation("u_rim_power");
+#if RIO_IS_WIN
+    mPixelUniformLocation[PIXEL_UNIFORM_ALPHA_FUNC] = mShader.getFragmentUniformLocation("PS_PUSH.alphaFunc");
+    mPixelUniformLocation[PIXEL_UNIFORM_ALPHA_REF] = mShader.getFragmentUniformLocation("PS_PUSH.alphaRef");
+#endif
 
     mSamplerLocation = mShader.getFragmentSamplerLocation("s_texture");
 
@@ -329,9 +380,10 @@ void Shader::initialize()
     GX2InitFetchShaderEx(&mFetchShader, (u8 *)buffer, FFL_ATTRIBUTE_BUFFER_TYPE_MAX, mAttribute, GX2_FETCH_SHADER_TESSELLATION_NONE, GX2_TESSELLATION_MODE_DISCRETE);
 #elif RIO_IS_WIN
     RIO_ASSERT(mVAOHandle == GL_NONE);
-    RIO_GL_CALL(glCreateBuffers(FFL_ATTRIBUTE_BUFFER_TYPE_MAX, mVBOHandle));
     RIO_GL_CALL(glCreateVertexArrays(1, &mVAOHandle));
     RIO_ASSERT(mVAOHandle != GL_NONE);
+
+    initializeUniformBlocks_();
 #endif
 
     mSampler.setWrap(rio::TEX_WRAP_MODE_MIRROR, rio::TEX_WRAP_MODE_MIRROR, rio::TEX_WRAP_MODE_MIRROR);
@@ -348,39 +400,81 @@ void Shader::bind(bool light_enable) const
     mShader.bind();
 #if RIO_IS_CAFE
     GX2SetFetchShader(&mFetchShader);
+
+    // Uniform registers are shared with every other shader, whatever ran since the last bind may have overwritten them.
+    invalidateUniformCache_();
 #elif RIO_IS_WIN
+    // Every shape binds its own VAO, this one never has any attribute arrays enabled.
     RIO_GL_CALL(glBindVertexArray(mVAOHandle));
-    for (u32 i = 0; i < FFL_ATTRIBUTE_BUFFER_TYPE_MAX; i++)
-        RIO_GL_CALL(glDisableVertexAttribArray(i));
+
+    // The light and rim constants never change, binding the block is all that's left to do.
+    RIO_GL_CALL(glBindBufferBase(GL_UNIFORM_BUFFER, cLightBlockBinding, mLightUBOHandle));
+    mBoundMaterial = -1;
+
+    mInstanceVBOHandle = GL_NONE;
+    mInstanceCount = 0;
+    setInstanced_(false);
 #endif
 
-    mShader.setUniform(cLightDir, u32(-1), mPixelUniformLocation[PIXEL_UNIFORM_LIGHT_DIR]);
-    mShader.setUniform(light_enable, u32(-1), mPixelUniformLocation[PIXEL_UNIFORM_LIGHT_ENABLE]);
-    mShader.setUniform(getColorUniform(cLightAmbient), u32(-1), mPixelUniformLocation[PIXEL_UNIFORM_LIGHT_AMBIENT]);
-    mShader.setUniform(getColorUniform(cLightDiffuse), u32(-1), mPixelUniformLocation[PIXEL_UNIFORM_LIGHT_DIFFUSE]);
-    mShader.setUniform(getColorUniform(cLightSpecular), u32(-1), mPixelUniformLocation[PIXEL_UNIFORM_LIGHT_SPECULAR]);
+    setPixelUniform_(PIXEL_UNIFORM_LIGHT_ENABLE, light_enable);
+
+#if RIO_IS_CAFE
+    setPixelUniform_(PIXEL_UNIFORM_LIGHT_DIR, cLightDir);
+    setPixelUniform_(PIXEL_UNIFORM_LIGHT_AMBIENT, getColorUniform(cLightAmbient));
+    setPixelUniform_(PIXEL_UNIFORM_LIGHT_DIFFUSE, getColorUniform(cLightDiffuse));
+    setPixelUniform_(PIXEL_UNIFORM_LIGHT_SPECULAR, getColorUniform(cLightSpecular));
 
-    mShader.setUniform(getColorUniform(cRimColor), u32(-1), mPixelUniformLocation[PIXEL_UNIFORM_RIM_COLOR]);
-    mShader.setUniform(cRimPower, u32(-1), mPixelUniformLocation[PIXEL_UNIFORM_RIM_POWER]);
+    setPixelUniform_(PIXEL_UNIFORM_RIM_COLOR, getColorUniform(cRimColor));
+    setPixelUniform_(PIXEL_UNIFORM_RIM_POWER, cRimPower);
+#endif
 }
 
-void Shader::setViewUniform(const rio::BaseMtx34f &model_mtx, const rio::BaseMtx34f &view_mtx, const rio::BaseMtx44f &proj_mtx) const
+void Shader::setProjUniform(const rio::BaseMtx44f &proj_mtx) const
 {
     mShader.setUniform(proj_mtx, mVertexUniformLocation[VERTEX_UNIFORM_PROJ], u32(-1));
+}
+
+void Shader::calcInstanceData(InstanceData *p_data, const rio::BaseMtx34f &mv_mtx, const rio::BaseMtx34f &it_mtx)
+{
+    static_cast<rio::Matrix44f &>(p_data->mv).fromMatrix34(static_cast<const rio::Matrix34f &>(mv_mtx));
+
+    // Columns, the same order setModelViewUniform() uploads u_it in.
+    for (u32 column = 0; column < 3; column++)
+        p_data->it[column] = {it_mtx.m[0][column], it_mtx.m[1][column], it_mtx.m[2][column]};
+}
+
+#if RIO_IS_WIN
+
+void Shader::setInstanceBuffer(u32 vbo_handle, u32 count)
+{
+    mInstanceVBOHandle = vbo_handle;
+    mInstanceCount = count;
+    setInstanced_(count > 0);
+}
+
+#endif // RIO_IS_WIN
+
+void Shader::setViewUniform(const rio::BaseMtx34f &model_mtx, const rio::BaseMtx34f &view_mtx, const rio::BaseMtx44f &proj_mtx) const
+{
+    setProjUniform(proj_mtx);
 
     rio::Matrix34f mv;
-    mv.setMul(static_cast<const rio::Matrix34f &>(view_mtx), static_cast<const rio::Matrix34f &>(model_mtx));
+    rio::Matrix34f it34;
+    MatrixBatch::ViewNormal(view_mtx, MatrixBatch::Stream(&model_mtx), MatrixBatch::Stream(&mv), MatrixBatch::Stream(&it34), 1);
+
+    setModelViewUniform(mv, it34);
+}
+
+void Shader::setModelViewUniform(const rio::BaseMtx34f &mv_mtx, const rio::BaseMtx34f &it_mtx) const
+{
     rio::Matrix44f mv44;
-    mv44.fromMatrix34(mv);
+    mv44.fromMatrix34(static_cast<const rio::Matrix34f &>(mv_mtx));
     mShader.setUniform(mv44, mVertexUniformLocation[VERTEX_UNIFORM_MV], u32(-1));
 
-    rio::Matrix34f it34 = mv;
-    it34.setInverseTranspose(mv);
-    gramSchmidtOrthonormalizeMtx34(&it34);
     rio::BaseMtx33f it{
-        it34.m[0][0], it34.m[1][0], it34.m[2][0],
-        it34.m[0][1], it34.m[1][1], it34.m[2][1],
-        it34.m[0][2], it34.m[1][2], it34.m[2][2]};
+        it_mtx.m[0][0], it_mtx.m[1][0], it_mtx.m[2][0],
+        it_mtx.m[0][1], it_mtx.m[1][1], it_mtx.m[2][1],
+        it_mtx.m[0][2], it_mtx.m[1][2], it_mtx.m[2][2]};
     mShader.setUniformColumnMajor(it, mVertexUniformLocation[VERTEX_UNIFORM_IT], u32(-1));
 }
 
@@ -389,8 +483,8 @@ void Shader::applyAlphaTest(bool enable, rio::Graphics::CompareFunc func, f32 re
 #if RIO_IS_CAFE
     GX2SetAlphaTest(enable, GX2CompareFunction(func), ref);
 #elif RIO_IS_WIN
-    mShader.setUniform(u32(func - GL_NEVER), u32(-1), mShader.getFragmentUniformLocation("PS_PUSH.alphaFunc"));
-    mShader.setUniform(ref, u32(-1), mShader.getFragmentUniformLocation("PS_PUSH.alphaRef"));
+    setPixelUniform_(PIXEL_UNIFORM_ALPHA_FUNC, u32(func - GL_NEVER));
+    setPixelUniform_(PIXEL_UNIFORM_ALPHA_REF, ref);
 #endif
 }
 
@@ -419,6 +513,25 @@ void Shader::setCulling(FFLCullMode mode)
     render_state.applyCullingAndPolygonModeAndPolygonOffset();
 }
 
+void Shader::setCharModel(const FFLCharModel *p_char_model)
+{
+    mpCharModel = p_char_model;
+}
+
+void Shader::invalidateCharModel(const FFLCharModel *p_char_model)
+{
+#if RIO_IS_WIN
+    auto it = mDrawBuffers.lower_bound(DrawBufferKey(p_char_model, nullptr));
+    while (it != mDrawBuffers.end() && it->first.first == p_char_model)
+    {
+        destroyDrawBuffer_(&it->second);
+        it = mDrawBuffers.erase(it);
+    }
+#endif
+
+    mpCharModel = nullptr;
+}
+
 void Shader::applyAlphaTestCallback_(void *p_obj, bool enable, rio::Graphics::CompareFunc func, f32 ref)
 {
     static_cast<Shader *>(p_obj)->applyAlphaTest(enable, func, ref);
@@ -433,14 +546,14 @@ void Shader::bindTexture_(const FFLModulateParam &modulateParam)
     }
 }
 
-void Shader::setConstColor_(u32 ps_loc, const FFLColor &color)
+void Shader::setConstColor_(u32 uniform, const FFLColor &color)
 {
-    mShader.setUniform(getColorUniform(color), u32(-1), ps_loc);
+    setPixelUniform_(uniform, getColorUniform(color));
 }
 
 void Shader::setModulateMode_(FFLModulateMode mode)
 {
-    mShader.setUniform(s32(mode), u32(-1), mPixelUniformLocation[PIXEL_UNIFORM_MODE]);
+    setPixelUniform_(PIXEL_UNIFORM_MODE, s32(mode));
 }
 
 void Shader::setModulate_(const FFLModulateParam &modulateParam)
@@ -453,12 +566,12 @@ void Shader::setModulate_(const FFLModulateParam &modulateParam)
     case FFL_MODULATE_MODE_3:
     case FFL_MODULATE_MODE_4:
     case FFL_MODULATE_MODE_5:
-        setConstColor_(mPixelUniformLocation[PIXEL_UNIFORM_CONST1], *modulateParam.pColorR);
+        setConstColor_(PIXEL_UNIFORM_CONST1, *modulateParam.pColorR);
         break;
     case FFL_MODULATE_MODE_2:
-        setConstColor_(mPixelUniformLocation[PIXEL_UNIFORM_CONST1], *modulateParam.pColorR);
-        setConstColor_(mPixelUniformLocation[PIXEL_UNIFORM_CONST2], *modulateParam.pColorG);
-        setConstColor_(mPixelUniformLocation[PIXEL_UNIFORM_CONST3], *modulateParam.pColorB);
+        setConstColor_(PIXEL_UNIFORM_CONST1, *modulateParam.pColorR);
+        setConstColor_(PIXEL_UNIFORM_CONST2, *modulateParam.pColorG);
+        setConstColor_(PIXEL_UNIFORM_CONST3, *modulateParam.pColorB);
         break;
     default:
         break;
@@ -472,16 +585,33 @@ void Shader::setMaterial_(const FFLDrawParam &drawParam)
     if (drawParam.modulateParam.type >= cMaterialParamSize)
         return;
 
-    mShader.setUniform(getColorUniform(cMaterialParam[drawParam.modulateParam.type].ambient), u32(-1), mPixelUniformLocation[PIXEL_UNIFORM_MATERIAL_AMBIENT]);
-    mShader.setUniform(getColorUniform(cMaterialParam[drawParam.modulateParam.type].diffuse), u32(-1), mPixelUniformLocation[PIXEL_UNIFORM_MATERIAL_DIFFUSE]);
-    mShader.setUniform(getColorUniform(cMaterialParam[drawParam.modulateParam.type].specular), u32(-1), mPixelUniformLocation[PIXEL_UNIFORM_MATERIAL_SPECULAR]);
-    mShader.setUniform(cMaterialParam[drawParam.modulateParam.type].specularPower, u32(-1), mPixelUniformLocation[PIXEL_UNIFORM_MATERIAL_SPECULAR_POWER]);
+#if RIO_IS_WIN
+    // Every type has two entries in the material buffer, the second one with specular mode 0 for shapes without tangents.
+    s32 material = drawParam.modulateParam.type * 2;
+    if (drawParam.attributeBufferParam.attributeBuffers[FFL_ATTRIBUTE_BUFFER_TYPE_TANGENT].ptr == nullptr)
+        material++;
+
+    if (material == mBoundMaterial)
+    {
+        mUniformStats.skipped++;
+        return;
+    }
+
+    RIO_GL_CALL(glBindBufferRange(GL_UNIFORM_BUFFER, cMaterialBlockBinding, mMaterialUBOHandle, material * mMaterialUBOStride, sizeof(MaterialBlock)));
+    mBoundMaterial = material;
+    mUniformStats.issued++;
+#else
+    setPixelUniform_(PIXEL_UNIFORM_MATERIAL_AMBIENT, getColorUniform(cMaterialParam[drawParam.modulateParam.type].ambient));
+    setPixelUniform_(PIXEL_UNIFORM_MATERIAL_DIFFUSE, getColorUniform(cMaterialParam[drawParam.modulateParam.type].diffuse));
+    setPixelUniform_(PIXEL_UNIFORM_MATERIAL_SPECULAR, getColorUniform(cMaterialParam[drawParam.modulateParam.type].specular));
+    setPixelUniform_(PIXEL_UNIFORM_MATERIAL_SPECULAR_POWER, cMaterialParam[drawParam.modulateParam.type].specularPower);
 
     s32 materialSpecularMode = cMaterialParam[drawParam.modulateParam.type].specularMode;
     if (drawParam.attributeBufferParam.attributeBuffers[FFL_ATTRIBUTE_BUFFER_TYPE_TANGENT].ptr == nullptr)
         materialSpecularMode = 0;
 
-    mShader.setUniform(materialSpecularMode, u32(-1), mPixelUniformLocation[PIXEL_UNIFORM_MATERIAL_SPECULAR_MODE]);
+    setPixelUniform_(PIXEL_UNIFORM_MATERIAL_SPECULAR_MODE, materialSpecularMode);
+#endif
 }
 
 void Shader::draw_(const FFLDrawParam &draw_param)
@@ -519,180 +649,20 @@ void Shader::draw_(const FFLDrawParam &draw_param)
             draw_param.attributeBufferParam.attributeBuffers[FFL_ATTRIBUTE_BUFFER_TYPE_COLOR].stride,
             draw_param.attributeBufferParam.attributeBuffers[FFL_ATTRIBUTE_BUFFER_TYPE_COLOR].ptr);
 #elif RIO_IS_WIN
+        DrawBuffer &drawBuffer = getDrawBuffer_(draw_param);
+        RIO_GL_CALL(glBindVertexArray(drawBuffer.vaoHandle));
+        setConstantAttributes_(draw_param);
+
+        if (mInstanceCount > 0)
         {
-            FFLAttributeBufferType type = FFL_ATTRIBUTE_BUFFER_TYPE_POSITION;
-
-            const FFLAttributeBuffer &buffer = draw_param.attributeBufferParam.attributeBuffers[type];
-            s32 location = mAttributeLocation[type];
-
-            void *ptr = buffer.ptr;
-
-            if (ptr && location != -1)
-            {
-                u32 stride = buffer.stride;
-
-                if (stride == 0)
-                {
-                    RIO_GL_CALL(glVertexAttrib3fv(location, static_cast<f32 *>(ptr)));
-                }
-                else
-                {
-                    u32 vbo_handle = mVBOHandle[type];
-                    u32 size = buffer.size;
-
-                    RIO_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, vbo_handle));
-                    RIO_GL_CALL(glBufferData(GL_ARRAY_BUFFER, size, ptr, GL_STATIC_DRAW));
-
-                    RIO_GL_CALL(glEnableVertexAttribArray(location));
-                    RIO_GL_CALL(glVertexAttribPointer(
-                        location,
-                        3,
-                        GL_FLOAT,
-                        false,
-                        stride,
-                        nullptr));
-                }
-            }
-        }
-        {
-            FFLAttributeBufferType type = FFL_ATTRIBUTE_BUFFER_TYPE_TEXCOORD;
-
-            const FFLAttributeBuffer &buffer = draw_param.attributeBufferParam.attributeBuffers[type];
-            s32 location = mAttributeLocation[type];
-
-            void *ptr = buffer.ptr;
-
-            if (ptr && location != -1)
-            {
-                u32 stride = buffer.stride;
-
-                if (stride == 0)
-                {
-                    RIO_GL_CALL(glVertexAttrib2fv(location, static_cast<f32 *>(ptr)));
-                }
-                else
-                {
-                    u32 vbo_handle = mVBOHandle[type];
-                    u32 size = buffer.size;
-
-                    RIO_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, vbo_handle));
-                    RIO_GL_CALL(glBufferData(GL_ARRAY_BUFFER, size, ptr, GL_STATIC_DRAW));
-
-                    RIO_GL_CALL(glEnableVertexAttribArray(location));
-                    RIO_GL_CALL(glVertexAttribPointer(
-                        location,
-                        2,
-                        GL_FLOAT,
-                        false,
-                        stride,
-                        nullptr));
-                }
-            }
-        }
-        {
-            FFLAttributeBufferType type = FFL_ATTRIBUTE_BUFFER_TYPE_NORMAL;
-
-            const FFLAttributeBuffer &buffer = draw_param.attributeBufferParam.attributeBuffers[type];
-            s32 location = mAttributeLocation[type];
-
-            void *ptr = buffer.ptr;
-
-            if (ptr && location != -1)
-            {
-                u32 stride = buffer.stride;
-
-                if (stride == 0)
-                {
-                    RIO_GL_CALL(glVertexAttribP4ui(location, GL_INT_2_10_10_10_REV, true, *static_cast<u32 *>(ptr)));
-                }
-                else
-                {
-                    u32 vbo_handle = mVBOHandle[type];
-                    u32 size = buffer.size;
-
-                    RIO_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, vbo_handle));
-                    RIO_GL_CALL(glBufferData(GL_ARRAY_BUFFER, size, ptr, GL_STATIC_DRAW));
-
-                    RIO_GL_CALL(glEnableVertexAttribArray(location));
-                    RIO_GL_CALL(glVertexAttribPointer(
-                        location,
-                        4,
-                        GL_INT_2_10_10_10_REV,
-                        true,
-                        stride,
-                        nullptr));
-                }
-            }
-        }
-        {
-            FFLAttributeBufferType type = FFL_ATTRIBUTE_BUFFER_TYPE_TANGENT;
-
-            const FFLAttributeBuffer &buffer = draw_param.attributeBufferParam.attributeBuffers[type];
-            s32 location = mAttributeLocation[type];
-
-            void *ptr = buffer.ptr;
-
-            if (ptr && location != -1)
-            {
-                u32 stride = buffer.stride;
-
-                if (stride == 0)
-                {
-                    RIO_GL_CALL(glVertexAttrib4Nbv(location, static_cast<s8 *>(ptr)));
-                }
-                else
-                {
-                    u32 vbo_handle = mVBOHandle[type];
-                    u32 size = buffer.size;
-
-                    RIO_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, vbo_handle));
-                    RIO_GL_CALL(glBufferData(GL_ARRAY_BUFFER, size, ptr, GL_STATIC_DRAW));
-
-                    RIO_GL_CALL(glEnableVertexAttribArray(location));
-                    RIO_GL_CALL(glVertexAttribPointer(
-                        location,
-                        4,
-                        GL_BYTE,
-                        true,
-                        stride,
-                        nullptr));
-                }
-            }
-        }
-        {
-            FFLAttributeBufferType type = FFL_ATTRIBUTE_BUFFER_TYPE_COLOR;
-
-            const FFLAttributeBuffer &buffer = draw_param.attributeBufferParam.attributeBuffers[type];
-            s32 location = mAttributeLocation[type];
-
-            void *ptr = buffer.ptr;
-
-            if (ptr && location != -1)
-            {
-                u32 stride = buffer.stride;
-
-                if (stride == 0)
-                {
-                    RIO_GL_CALL(glVertexAttrib4Nubv(location, static_cast<u8 *>(ptr)));
-                }
-                else
-                {
-                    u32 vbo_handle = mVBOHandle[type];
-                    u32 size = buffer.size;
-
-                    RIO_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, vbo_handle));
-                    RIO_GL_CALL(glBufferData(GL_ARRAY_BUFFER, size, ptr, GL_STATIC_DRAW));
-
-                    RIO_GL_CALL(glEnableVertexAttribArray(location));
-                    RIO_GL_CALL(glVertexAttribPointer(
-                        location,
-                        4,
-                        GL_UNSIGNED_BYTE,
-                        true,
-                        stride,
-                        nullptr));
-                }
-            }
+            bindInstanceBuffer_(&drawBuffer);
+            RIO_GL_CALL(glDrawElementsInstanced(
+                draw_param.primitiveParam.primitiveType,
+                draw_param.primitiveParam.indexCount,
+                GL_UNSIGNED_SHORT,
+                draw_param.primitiveParam.pIndexBuffer,
+                mInstanceCount));
+            return;
         }
 #endif
 
@@ -703,6 +673,226 @@ void Shader::draw_(const FFLDrawParam &draw_param)
     }
 }
 
+#if RIO_IS_WIN
+
+Shader::DrawBuffer &Shader::getDrawBuffer_(const FFLDrawParam &draw_param)
+{
+    if (mpCharModel == nullptr)
+    {
+        destroyDrawBuffer_(&mScratchBuffer);
+        createDrawBuffer_(&mScratchBuffer, draw_param);
+        return mScratchBuffer;
+    }
+
+    DrawBufferKey key(mpCharModel, draw_param.primitiveParam.pIndexBuffer);
+
+    auto it = mDrawBuffers.find(key);
+    if (it != mDrawBuffers.end())
+    {
+        if (isDrawBufferValid_(it->second, draw_param))
+            return it->second;
+
+        // FFL reused the index buffer address for a different shape, upload it again.
+        destroyDrawBuffer_(&it->second);
+        createDrawBuffer_(&it->second, draw_param);
+        return it->second;
+    }
+
+    DrawBuffer &buffer = mDrawBuffers[key];
+    createDrawBuffer_(&buffer, draw_param);
+    return buffer;
+}
+
+void Shader::createDrawBuffer_(DrawBuffer *p_buffer, const FFLDrawParam &draw_param) const
+{
+    rio::MemUtil::set(p_buffer, 0, sizeof(DrawBuffer));
+
+    RIO_GL_CALL(glCreateVertexArrays(1, &p_buffer->vaoHandle));
+    RIO_GL_CALL(glBindVertexArray(p_buffer->vaoHandle));
+
+    for (u32 type = 0; type < FFL_ATTRIBUTE_BUFFER_TYPE_MAX; type++)
+    {
+        const FFLAttributeBuffer &buffer = draw_param.attributeBufferParam.attributeBuffers[type];
+        s32 location = mAttributeLocation[type];
+
+        p_buffer->ptr[type] = buffer.ptr;
+        p_buffer->size[type] = buffer.size;
+
+        // Constant attributes are not part of the VAO state, they get set on every draw instead.
+        if (buffer.ptr == nullptr || location == -1 || buffer.stride == 0)
+            continue;
+
+        const AttributeFormat &format = cAttributeFormat[type];
+
+        RIO_GL_CALL(glCreateBuffers(1, &p_buffer->vboHandle[type]));
+        RIO_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, p_buffer->vboHandle[type]));
+        RIO_GL_CALL(glBufferData(GL_ARRAY_BUFFER, buffer.size, buffer.ptr, GL_STATIC_DRAW));
+
+        RIO_GL_CALL(glEnableVertexAttribArray(location));
+        RIO_GL_CALL(glVertexAttribPointer(
+            location,
+            format.count,
+            format.type,
+            format.normalized,
+            buffer.stride,
+            nullptr));
+    }
+}
+
+void Shader::destroyDrawBuffer_(DrawBuffer *p_buffer)
+{
+    for (u32 type = 0; type < FFL_ATTRIBUTE_BUFFER_TYPE_MAX; type++)
+    {
+        if (p_buffer->vboHandle[type] != GL_NONE)
+            RIO_GL_CALL(glDeleteBuffers(1, &p_buffer->vboHandle[type]));
+    }
+
+    if (p_buffer->vaoHandle != GL_NONE)
+        RIO_GL_CALL(glDeleteVertexArrays(1, &p_buffer->vaoHandle));
+
+    rio::MemUtil::set(p_buffer, 0, sizeof(DrawBuffer));
+}
+
+bool Shader::isDrawBufferValid_(const DrawBuffer &buffer, const FFLDrawParam &draw_param)
+{
+    for (u32 type = 0; type < FFL_ATTRIBUTE_BUFFER_TYPE_MAX; type++)
+    {
+        const FFLAttributeBuffer &attribute = draw_param.attributeBufferParam.attributeBuffers[type];
+        if (buffer.ptr[type] != attribute.ptr || buffer.size[type] != attribute.size)
+            return false;
+    }
+
+    return true;
+}
+
+void Shader::setConstantAttributes_(const FFLDrawParam &draw_param) const
+{
+    for (u32 type = 0; type < FFL_ATTRIBUTE_BUFFER_TYPE_MAX; type++)
+    {
+        const FFLAttributeBuffer &buffer = draw_param.attributeBufferParam.attributeBuffers[type];
+        s32 location = mAttributeLocation[type];
+
+        if (buffer.ptr == nullptr || location == -1 || buffer.stride != 0)
+            continue;
+
+        switch (type)
+        {
+        case FFL_ATTRIBUTE_BUFFER_TYPE_POSITION:
+            RIO_GL_CALL(glVertexAttrib3fv(location, static_cast<f32 *>(buffer.ptr)));
+            break;
+        case FFL_ATTRIBUTE_BUFFER_TYPE_TEXCOORD:
+            RIO_GL_CALL(glVertexAttrib2fv(location, static_cast<f32 *>(buffer.ptr)));
+            break;
+        case FFL_ATTRIBUTE_BUFFER_TYPE_NORMAL:
+            RIO_GL_CALL(glVertexAttribP4ui(location, GL_INT_2_10_10_10_REV, true, *static_cast<u32 *>(buffer.ptr)));
+            break;
+        case FFL_ATTRIBUTE_BUFFER_TYPE_TANGENT:
+            RIO_GL_CALL(glVertexAttrib4Nbv(location, static_cast<s8 *>(buffer.ptr)));
+            break;
+        case FFL_ATTRIBUTE_BUFFER_TYPE_COLOR:
+            RIO_GL_CALL(glVertexAttrib4Nubv(location, static_cast<u8 *>(buffer.ptr)));
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+// The instance attributes are VAO state, so they only need to be pointed at the buffer again when it changes.
+void Shader::bindInstanceBuffer_(DrawBuffer *p_buffer) const
+{
+    if (p_buffer->instanceVBOHandle == mInstanceVBOHandle)
+        return;
+
+    RIO_GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, mInstanceVBOHandle));
+
+    for (u32 column = 0; column < 4; column++)
+    {
+        u32 location = cInstanceAttribLocation + column;
+
+        RIO_GL_CALL(glEnableVertexAttribArray(location));
+        RIO_GL_CALL(glVertexAttribPointer(
+            location,
+            4,
+            GL_FLOAT,
+            false,
+            sizeof(InstanceData),
+            reinterpret_cast<const void *>(offsetof(InstanceData, mv) + column * sizeof(rio::BaseVec4f))));
+        RIO_GL_CALL(glVertexAttribDivisor(location, 1));
+    }
+
+    for (u32 column = 0; column < 3; column++)
+    {
+        u32 location = cInstanceNormalAttribLocation + column;
+
+        RIO_GL_CALL(glEnableVertexAttribArray(location));
+        RIO_GL_CALL(glVertexAttribPointer(
+            location,
+            3,
+            GL_FLOAT,
+            false,
+            sizeof(InstanceData),
+            reinterpret_cast<const void *>(offsetof(InstanceData, it) + column * sizeof(rio::BaseVec3f))));
+        RIO_GL_CALL(glVertexAttribDivisor(location, 1));
+    }
+
+    p_buffer->instanceVBOHandle = mInstanceVBOHandle;
+}
+
+void Shader::initializeUniformBlocks_()
+{
+    // rio::Shader does not expose its program, take it from the GL state instead.
+    mShader.bind();
+    GLint program = 0;
+    RIO_GL_CALL(glGetIntegerv(GL_CURRENT_PROGRAM, &program));
+
+    u32 lightBlockIndex = glGetUniformBlockIndex(program, "u_light_block");
+    u32 materialBlockIndex = glGetUniformBlockIndex(program, "u_material_block");
+    RIO_ASSERT(lightBlockIndex != GL_INVALID_INDEX && materialBlockIndex != GL_INVALID_INDEX);
+
+    RIO_GL_CALL(glUniformBlockBinding(program, lightBlockIndex, cLightBlockBinding));
+    RIO_GL_CALL(glUniformBlockBinding(program, materialBlockIndex, cMaterialBlockBinding));
+
+    LightBlock light;
+    rio::MemUtil::set(&light, 0, sizeof(LightBlock));
+    light.ambient = cLightAmbient;
+    light.diffuse = cLightDiffuse;
+    light.specular = cLightSpecular;
+    light.dir = cLightDir;
+    light.rimColor = cRimColor;
+    light.rimPower = cRimPower;
+
+    RIO_GL_CALL(glCreateBuffers(1, &mLightUBOHandle));
+    RIO_GL_CALL(glNamedBufferData(mLightUBOHandle, sizeof(LightBlock), &light, GL_STATIC_DRAW));
+
+    // Every entry has to start on the uniform buffer offset alignment to be bound as a range.
+    GLint alignment = 0;
+    RIO_GL_CALL(glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment));
+    mMaterialUBOStride = (sizeof(MaterialBlock) + alignment - 1) / alignment * alignment;
+
+    std::vector<u8> materialData(mMaterialUBOStride * cMaterialParamSize * 2, 0);
+    for (u32 type = 0; type < cMaterialParamSize; type++)
+    {
+        MaterialBlock material;
+        rio::MemUtil::set(&material, 0, sizeof(MaterialBlock));
+        material.ambient = cMaterialParam[type].ambient;
+        material.diffuse = cMaterialParam[type].diffuse;
+        material.specular = cMaterialParam[type].specular;
+        material.specularPower = cMaterialParam[type].specularPower;
+
+        material.specularMode = cMaterialParam[type].specularMode;
+        rio::MemUtil::copy(&materialData[(type * 2) * mMaterialUBOStride], &material, sizeof(MaterialBlock));
+
+        material.specularMode = 0;
+        rio::MemUtil::copy(&materialData[(type * 2 + 1) * mMaterialUBOStride], &material, sizeof(MaterialBlock));
+    }
+
+    RIO_GL_CALL(glCreateBuffers(1, &mMaterialUBOHandle));
+    RIO_GL_CALL(glNamedBufferData(mMaterialUBOHandle, materialData.size(), materialData.data(), GL_STATIC_DRAW));
+}
+
+#endif // RIO_IS_WIN
+
 void Shader::drawCallback_(void *p_obj, const FFLDrawParam &draw_param)
 {
     static_cast<Shader *>(p_obj)->draw_(draw_param);
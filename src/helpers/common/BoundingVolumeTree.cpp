@@ -0,0 +1,352 @@
+#include <helpers/common/BoundingVolumeTree.h>
+
+#include <algorithm>
+
+BoundingVolumeTree::ProxyID BoundingVolumeTree::Insert(const BoundingBox &pBox, void *pUserData)
+{
+    RIO_ASSERT(!pBox.IsEmpty());
+
+    u32 leaf = AllocateNode();
+
+    TreeNode &node = mNodes[leaf];
+    node.box = pBox;
+    node.fatBox = pBox;
+    node.fatBox.Grow(mMargin);
+    node.userData = pUserData;
+
+    InsertLeaf(leaf);
+    mProxyCount++;
+
+    return leaf;
+}
+
+void BoundingVolumeTree::Remove(ProxyID pProxy)
+{
+    RIO_ASSERT(pProxy < mNodes.size() && mNodes[pProxy].height == 0);
+
+    RemoveLeaf(pProxy);
+    FreeNode(pProxy);
+    mProxyCount--;
+}
+
+bool BoundingVolumeTree::Update(ProxyID pProxy, const BoundingBox &pBox)
+{
+    RIO_ASSERT(pProxy < mNodes.size() && mNodes[pProxy].height == 0);
+    RIO_ASSERT(!pBox.IsEmpty());
+
+    TreeNode &node = mNodes[pProxy];
+    node.box = pBox;
+
+    // Proxies that shrank a lot are moved too, or their grown box would keep matching queries it has nothing to do with.
+    BoundingBox looseBox = pBox;
+    looseBox.Grow(mMargin * 4.f);
+
+    if (node.fatBox.Contains(pBox) && looseBox.Contains(node.fatBox))
+        return false;
+
+    RemoveLeaf(pProxy);
+
+    mNodes[pProxy].fatBox = pBox;
+    mNodes[pProxy].fatBox.Grow(mMargin);
+
+    InsertLeaf(pProxy);
+    return true;
+}
+
+void BoundingVolumeTree::Clear()
+{
+    mNodes.clear();
+    mRoot = cNullProxy;
+    mFreeList = cNullProxy;
+    mProxyCount = 0;
+}
+
+void BoundingVolumeTree::QueryFrustum(const Frustum &pFrustum, std::vector<void *> *pOut) const
+{
+    if (mRoot == cNullProxy)
+        return;
+
+    u32 stack[cMaxStackSize];
+    u32 stackSize = 0;
+    stack[stackSize++] = mRoot;
+
+    while (stackSize > 0)
+    {
+        const TreeNode &node = mNodes[stack[--stackSize]];
+
+        if (node.IsLeaf())
+        {
+            if (pFrustum.IsVisible(node.box))
+                pOut->push_back(node.userData);
+
+            continue;
+        }
+
+        if (!pFrustum.IsVisible(node.fatBox))
+            continue;
+
+        RIO_ASSERT(stackSize + 2 <= cMaxStackSize);
+        stack[stackSize++] = node.child1;
+        stack[stackSize++] = node.child2;
+    }
+}
+
+void BoundingVolumeTree::QueryRadius(const rio::Vector3f &pCenter, f32 pRadius, std::vector<void *> *pOut) const
+{
+    if (mRoot == cNullProxy)
+        return;
+
+    f32 radiusSq = pRadius * pRadius;
+
+    u32 stack[cMaxStackSize];
+    u32 stackSize = 0;
+    stack[stackSize++] = mRoot;
+
+    while (stackSize > 0)
+    {
+        const TreeNode &node = mNodes[stack[--stackSize]];
+
+        if (node.IsLeaf())
+        {
+            if (node.box.GetDistanceSq(pCenter) <= radiusSq)
+                pOut->push_back(node.userData);
+
+            continue;
+        }
+
+        if (node.fatBox.GetDistanceSq(pCenter) > radiusSq)
+            continue;
+
+        RIO_ASSERT(stackSize + 2 <= cMaxStackSize);
+        stack[stackSize++] = node.child1;
+        stack[stackSize++] = node.child2;
+    }
+}
+
+void BoundingVolumeTree::QueryRay(const rio::Vector3f &pOrigin, const rio::Vector3f &pDirection, f32 pMaxDistance, std::vector<RayHit> *pOut) const
+{
+    if (mRoot == cNullProxy)
+        return;
+
+    rio::Vector3f invDirection = {1.f / pDirection.x, 1.f / pDirection.y, 1.f / pDirection.z};
+    size_t firstHit = pOut->size();
+
+    u32 stack[cMaxStackSize];
+    u32 stackSize = 0;
+    stack[stackSize++] = mRoot;
+
+    while (stackSize > 0)
+    {
+        const TreeNode &node = mNodes[stack[--stackSize]];
+        f32 distance;
+
+        if (node.IsLeaf())
+        {
+            if (node.box.IntersectRay(pOrigin, invDirection, pMaxDistance, &distance))
+                pOut->push_back({node.userData, distance});
+
+            continue;
+        }
+
+        if (!node.fatBox.IntersectRay(pOrigin, invDirection, pMaxDistance, &distance))
+            continue;
+
+        RIO_ASSERT(stackSize + 2 <= cMaxStackSize);
+        stack[stackSize++] = node.child1;
+        stack[stackSize++] = node.child2;
+    }
+
+    std::sort(pOut->begin() + firstHit, pOut->end(), [](const RayHit &pA, const RayHit &pB)
+              { return pA.distance < pB.distance; });
+}
+
+u32 BoundingVolumeTree::AllocateNode()
+{
+    if (mFreeList == cNullProxy)
+    {
+        mNodes.emplace_back();
+        mNodes.back().height = 0;
+
+        return mNodes.size() - 1;
+    }
+
+    u32 index = mFreeList;
+    mFreeList = mNodes[index].parent;
+
+    mNodes[index] = TreeNode();
+    mNodes[index].height = 0;
+
+    return index;
+}
+
+void BoundingVolumeTree::FreeNode(u32 pNode)
+{
+    mNodes[pNode] = TreeNode();
+    mNodes[pNode].parent = mFreeList;
+    mFreeList = pNode;
+}
+
+// Walks down from the root towards the child whose box grows the least, and stops once
+// pairing with the current node is cheaper than the least that any node below could cost.
+u32 BoundingVolumeTree::FindBestSibling(const BoundingBox &pBox) const
+{
+    u32 index = mRoot;
+
+    while (!mNodes[index].IsLeaf())
+    {
+        const TreeNode &node = mNodes[index];
+
+        f32 area = node.fatBox.GetHalfArea();
+        f32 combinedArea = BoundingBox::Merge(node.fatBox, pBox).GetHalfArea();
+
+        // A new parent for this node and the box, and what every node on the way down grows by anyway.
+        f32 cost = 2.f * combinedArea;
+        f32 inheritedCost = 2.f * (combinedArea - area);
+
+        auto childCost = [this, &pBox, inheritedCost](u32 pChild)
+        {
+            const TreeNode &child = mNodes[pChild];
+            f32 mergedArea = BoundingBox::Merge(child.fatBox, pBox).GetHalfArea();
+
+            if (child.IsLeaf())
+                return mergedArea + inheritedCost;
+
+            return mergedArea - child.fatBox.GetHalfArea() + inheritedCost;
+        };
+
+        f32 cost1 = childCost(node.child1);
+        f32 cost2 = childCost(node.child2);
+
+        if (cost < cost1 && cost < cost2)
+            break;
+
+        index = cost1 < cost2 ? node.child1 : node.child2;
+    }
+
+    return index;
+}
+
+void BoundingVolumeTree::InsertLeaf(u32 pLeaf)
+{
+    if (mRoot == cNullProxy)
+    {
+        mRoot = pLeaf;
+        mNodes[pLeaf].parent = cNullProxy;
+        return;
+    }
+
+    u32 sibling = FindBestSibling(mNodes[pLeaf].fatBox);
+    u32 oldParent = mNodes[sibling].parent;
+
+    // Can grow mNodes, so no references into it are held across this.
+    u32 newParent = AllocateNode();
+
+    TreeNode &parentNode = mNodes[newParent];
+    parentNode.parent = oldParent;
+    parentNode.fatBox = BoundingBox::Merge(mNodes[sibling].fatBox, mNodes[pLeaf].fatBox);
+    parentNode.height = mNodes[sibling].height + 1;
+    parentNode.child1 = sibling;
+    parentNode.child2 = pLeaf;
+
+    if (oldParent == cNullProxy)
+        mRoot = newParent;
+    else if (mNodes[oldParent].child1 == sibling)
+        mNodes[oldParent].child1 = newParent;
+    else
+        mNodes[oldParent].child2 = newParent;
+
+    mNodes[sibling].parent = newParent;
+    mNodes[pLeaf].parent = newParent;
+
+    Refit(oldParent);
+}
+
+void BoundingVolumeTree::RemoveLeaf(u32 pLeaf)
+{
+    if (pLeaf == mRoot)
+    {
+        mRoot = cNullProxy;
+        return;
+    }
+
+    u32 parent = mNodes[pLeaf].parent;
+    u32 grandParent = mNodes[parent].parent;
+    u32 sibling = mNodes[parent].child1 == pLeaf ? mNodes[parent].child2 : mNodes[parent].child1;
+
+    // The sibling takes the place of the parent.
+    if (grandParent == cNullProxy)
+        mRoot = sibling;
+    else if (mNodes[grandParent].child1 == parent)
+        mNodes[grandParent].child1 = sibling;
+    else
+        mNodes[grandParent].child2 = sibling;
+
+    mNodes[sibling].parent = grandParent;
+    FreeNode(parent);
+
+    Refit(grandParent);
+}
+
+void BoundingVolumeTree::Refit(u32 pNode)
+{
+    for (u32 index = pNode; index != cNullProxy; index = mNodes[index].parent)
+    {
+        index = Balance(index);
+
+        TreeNode &node = mNodes[index];
+        const TreeNode &child1 = mNodes[node.child1];
+        const TreeNode &child2 = mNodes[node.child2];
+
+        node.height = 1 + std::max(child1.height, child2.height);
+        node.fatBox = BoundingBox::Merge(child1.fatBox, child2.fatBox);
+    }
+}
+
+// The taller child takes pNode's place. pNode becomes its child and takes over the shorter of the grandchildren,
+// the taller grandchild stays where it was.
+u32 BoundingVolumeTree::Balance(u32 pNode)
+{
+    TreeNode &a = mNodes[pNode];
+    if (a.IsLeaf() || a.height < 2)
+        return pNode;
+
+    s32 balance = mNodes[a.child2].height - mNodes[a.child1].height;
+    if (balance >= -1 && balance <= 1)
+        return pNode;
+
+    // Which child goes up, and which of pNode's child slots it leaves free.
+    u32 up = balance > 1 ? a.child2 : a.child1;
+    u32 stay = balance > 1 ? a.child1 : a.child2;
+    u32 &freedSlot = balance > 1 ? a.child2 : a.child1;
+
+    TreeNode &c = mNodes[up];
+    u32 f = c.child1;
+    u32 g = c.child2;
+
+    // Keep the taller grandchild next to pNode and give the shorter one to pNode.
+    if (mNodes[f].height < mNodes[g].height)
+        std::swap(f, g);
+
+    c.child1 = pNode;
+    c.child2 = f;
+    c.parent = a.parent;
+    a.parent = up;
+
+    if (c.parent == cNullProxy)
+        mRoot = up;
+    else if (mNodes[c.parent].child1 == pNode)
+        mNodes[c.parent].child1 = up;
+    else
+        mNodes[c.parent].child2 = up;
+
+    freedSlot = g;
+    mNodes[g].parent = pNode;
+
+    a.fatBox = BoundingBox::Merge(mNodes[stay].fatBox, mNodes[g].fatBox);
+    a.height = 1 + std::max(mNodes[stay].height, mNodes[g].height);
+
+    c.fatBox = BoundingBox::Merge(a.fatBox, mNodes[f].fatBox);
+    c.height = 1 + std::max(a.height, mNodes[f].height);
+
+    return up;
+}
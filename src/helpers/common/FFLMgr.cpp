@@ -1,8 +1,11 @@
 #include <helpers/common/FFLMgr.h>
+#include <Shader.h>
+#include <helpers/common/MiiHeadBatch.h>
 #include <nn/ffl.h>
 #include <string>
 #include <filedevice/rio_FileDeviceMgr.h>
 #include <misc/rio_MemUtil.h>
+#include <fstream>
 
 FFLMgr *FFLMgr::mInstance = nullptr;
 
@@ -33,20 +36,26 @@ bool FFLMgr::destorySingleton()
 
     RIO_LOG("[FFLMGR] Exiting FFL..\n");
 
-    FFLExit();
-
-    // Free the resources and set pointers to nullptr.
-    if (mInstance->mResourceDesc.pData[FFL_RESOURCE_TYPE_HIGH])
+    for (auto &entry : mInstance->mMiiHeadBatches)
     {
-        rio::MemUtil::free(mInstance->mResourceDesc.pData[FFL_RESOURCE_TYPE_HIGH]);
-        // mInstance->mResourceDesc.pData[FFL_RESOURCE_TYPE_HIGH] = nullptr;
+        delete entry.second;
+        mInstance->ReleaseShader();
     }
-    if (mInstance->mResourceDesc.pData[FFL_RESOURCE_TYPE_MIDDLE])
+    mInstance->mMiiHeadBatches.clear();
+    mInstance->mUnusedMiiHeadBatches.clear();
+
+    if (mInstance->mpShader)
     {
-        rio::MemUtil::free(mInstance->mResourceDesc.pData[FFL_RESOURCE_TYPE_MIDDLE]);
-        // mInstance->mResourceDesc.pData[FFL_RESOURCE_TYPE_MIDDLE] = nullptr;
+        RIO_LOG("[FFLMGR] Shader still has %u references on exit.\n", mInstance->mShaderRefCount);
+        delete mInstance->mpShader;
     }
 
+    FFLExit();
+
+    // Unmap the resources.
+    for (MappedFile &resourceFile : mInstance->mResourceFiles)
+        resourceFile.Close();
+
     if (mInstance->miiBufferSize)
     {
         rio::MemUtil::free(mInstance->miiBufferSize);
@@ -58,6 +67,136 @@ bool FFLMgr::destorySingleton()
     return true;
 }
 
+Shader *FFLMgr::AcquireShader()
+{
+    if (mShaderRefCount++ == 0)
+    {
+        mpShader = new Shader();
+        mpShader->initialize();
+        mpShader->bind(false);
+        RIO_LOG("[FFLMGR] Created shared FFL shader.\n");
+    }
+
+    return mpShader;
+}
+
+void FFLMgr::ReleaseShader()
+{
+    RIO_ASSERT(mShaderRefCount > 0);
+
+    if (--mShaderRefCount > 0)
+        return;
+
+    delete mpShader;
+    mpShader = nullptr;
+    RIO_LOG("[FFLMGR] Deleted shared FFL shader.\n");
+}
+
+MiiHeadBatch *FFLMgr::AcquireMiiHeadBatch(const FFLStoreData &pStoreData, u32 pExpressionFlag, const rio::BaseMtx34f *pModelMtx)
+{
+    // TODO: make most of this customizable.
+    FFLCharModelDesc desc;
+    desc.resolution = mResolution;
+    desc.expressionFlag = pExpressionFlag;
+    desc.resourceType = FFL_RESOURCE_TYPE_HIGH;
+    desc.modelFlag = 1 << 0 | 1 << 1 | 1 << 2;
+
+    MiiHeadBatch::Key key = MiiHeadBatch::MakeKey(pStoreData, desc);
+
+    auto range = mMiiHeadBatches.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        MiiHeadBatch *batch = it->second;
+        if (!batch->Matches(pStoreData))
+            continue;
+
+        if (batch->GetInstanceCount() == 0)
+            mUnusedMiiHeadBatches.remove(batch);
+
+        batch->AddInstance(pModelMtx);
+        mCharModelCacheHits++;
+
+        return batch;
+    }
+
+    mCharModelCacheMisses++;
+
+    MiiHeadBatch *batch = new MiiHeadBatch(pStoreData, desc);
+    Shader *shader = AcquireShader();
+
+    if (!batch->Initialize(shader))
+    {
+        delete batch;
+        ReleaseShader();
+        return nullptr;
+    }
+
+    batch->AddInstance(pModelMtx);
+    mMiiHeadBatches.emplace(key, batch);
+    mCharModelCacheSize += batch->GetMemorySize();
+
+    EvictCharModels();
+
+    return batch;
+}
+
+void FFLMgr::ReleaseMiiHeadBatch(MiiHeadBatch *pBatch, const rio::BaseMtx34f *pModelMtx)
+{
+    pBatch->RemoveInstance(pModelMtx);
+    if (pBatch->GetInstanceCount() > 0)
+        return;
+
+    mUnusedMiiHeadBatches.push_front(pBatch);
+
+    EvictCharModels();
+}
+
+void FFLMgr::SetCharModelCacheBudget(size_t pBytes)
+{
+    mCharModelCacheBudget = pBytes;
+
+    EvictCharModels();
+}
+
+// CharModels in use are never evicted, the cache can stay over budget until they are released.
+void FFLMgr::EvictCharModels()
+{
+    while (mCharModelCacheSize > mCharModelCacheBudget && !mUnusedMiiHeadBatches.empty())
+    {
+        MiiHeadBatch *batch = mUnusedMiiHeadBatches.back();
+        mUnusedMiiHeadBatches.pop_back();
+
+        DeleteMiiHeadBatch(batch);
+    }
+}
+
+void FFLMgr::DeleteMiiHeadBatch(MiiHeadBatch *pBatch)
+{
+    auto range = mMiiHeadBatches.equal_range(pBatch->GetKey());
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (it->second == pBatch)
+        {
+            mMiiHeadBatches.erase(it);
+            break;
+        }
+    }
+
+    mCharModelCacheSize -= pBatch->GetMemorySize();
+
+    RIO_LOG("[FFLMGR] Evicted CharModel (%zu KiB), cache now at %zu / %zu KiB.\n",
+            pBatch->GetMemorySize() / 1024, mCharModelCacheSize / 1024, mCharModelCacheBudget / 1024);
+
+    delete pBatch;
+    ReleaseShader();
+}
+
+void FFLMgr::EndFrame()
+{
+    if (mpShader)
+        mpShader->endFrame();
+}
+
 void FFLMgr::CreateRandomMiddleDB(u16 pMiiLength)
 {
     miiBufferSize = new u8[FFLGetMiddleDBBufferSize(pMiiLength)];
@@ -66,27 +205,24 @@ void FFLMgr::CreateRandomMiddleDB(u16 pMiiLength)
     RIO_LOG("[FFLMGR] Created Random Middle DB.\n");
 }
 
-FFLStoreData FFLMgr::GetStoreDataFromFile(std::string fileName, rio::RawErrorCode *errCode)
+// Every call reads through its own stream, so Mii heads can load their store data on several threads at once.
+// Not a MappedFile, that falls back to the shared native file device whenever mapping fails.
+bool FFLMgr::GetStoreDataFromFile(const std::string &pFileName, FFLStoreData *pStoreData)
 {
-    rio::FileDevice *fileDevice = rio::FileDeviceMgr::instance()->getNativeFileDevice();
-    rio::FileHandle fileHandle;
-
-    fileDevice->open(&fileHandle, rio::FileDeviceMgr::instance()->getMainFileDevice()->getContentNativePath() + "/mii/" + fileName, rio::FileDevice::FILE_OPEN_FLAG_READ);
-
-    u8 readMiiData[sizeof(FFLStoreData)];
-    fileDevice->read(&fileHandle, readMiiData, sizeof(FFLStoreData));
+    std::string path = rio::FileDeviceMgr::instance()->getMainFileDevice()->getContentNativePath() + "/mii/" + pFileName;
 
-    FFLStoreData returnData;
-    rio::RawErrorCode returnErrCode = fileDevice->getLastRawError();
+    // Read into a copy so a short file leaves pStoreData as it was.
+    FFLStoreData storeData;
 
-    rio::MemUtil::copy(&returnData, readMiiData, sizeof(FFLStoreData));
-    rio::MemUtil::copy(errCode, &returnErrCode, sizeof(rio::RawErrorCode));
-
-    fileDevice->close(&fileHandle);
-
-    return returnData;
+    std::ifstream file(path, std::ios::binary);
+    if (!file.read(reinterpret_cast<char *>(&storeData), sizeof(FFLStoreData)))
+    {
+        RIO_LOG("[FFLMGR] Failed to read store data from %s\n", path.c_str());
+        return false;
+    }
 
-    delete[] readMiiData;
+    rio::MemUtil::copy(pStoreData, &storeData, sizeof(FFLStoreData));
+    return true;
 }
 
 void FFLMgr::InitializeFFL()
@@ -102,45 +238,21 @@ void FFLMgr::InitializeFFL()
 
     std::string resPath;
     resPath.resize(256);
-    // Middle
-    {
-        FFLGetResourcePath(resPath.data(), 256, FFL_RESOURCE_TYPE_MIDDLE, false);
-        {
-            rio::FileDevice::LoadArg arg;
-            arg.path = resPath;
-            arg.alignment = 0x2000;
-
-            u8 *buffer = rio::FileDeviceMgr::instance()->getNativeFileDevice()->tryLoad(arg);
-            if (buffer == nullptr)
-            {
-                RIO_LOG("NativeFileDevice failed to load: %s\n", resPath.c_str());
-                RIO_ASSERT(false);
-                return;
-            }
-
-            mResourceDesc.pData[FFL_RESOURCE_TYPE_MIDDLE] = buffer;
-            mResourceDesc.size[FFL_RESOURCE_TYPE_MIDDLE] = arg.read_size;
-        }
-    }
-    // High
+    // Middle, then high
+    for (u32 type = 0; type < FFL_RESOURCE_TYPE_MAX; type++)
     {
-        FFLGetResourcePath(resPath.data(), 256, FFL_RESOURCE_TYPE_HIGH, false);
+        FFLGetResourcePath(resPath.data(), 256, FFLResourceType(type), false);
+
+        MappedFile &resourceFile = mResourceFiles[type];
+        if (!resourceFile.Open(resPath.c_str(), 0x2000, true))
         {
-            rio::FileDevice::LoadArg arg;
-            arg.path = resPath;
-            arg.alignment = 0x2000;
-
-            u8 *buffer = rio::FileDeviceMgr::instance()->getNativeFileDevice()->tryLoad(arg);
-            if (buffer == nullptr)
-            {
-                RIO_LOG("NativeFileDevice failed to load: %s\n", resPath.c_str());
-                RIO_ASSERT(false);
-                return;
-            }
-
-            mResourceDesc.pData[FFL_RESOURCE_TYPE_HIGH] = buffer;
-            mResourceDesc.size[FFL_RESOURCE_TYPE_HIGH] = arg.read_size;
+            RIO_LOG("NativeFileDevice failed to load: %s\n", resPath.c_str());
+            RIO_ASSERT(false);
+            return;
         }
+
+        mResourceDesc.pData[type] = resourceFile.GetWritableData();
+        mResourceDesc.size[type] = resourceFile.GetSize();
     }
 
     FFLResult result = FFLInitResEx(&init_desc, &mResourceDesc);
@@ -151,6 +263,12 @@ void FFLMgr::InitializeFFL()
         return;
     }
 
+    for (const MappedFile &resourceFile : mResourceFiles)
+    {
+        RIO_LOG("[FFLMGR] Resource %s in %.2f ms, %zu of %zu KiB resident.\n", resourceFile.IsMapped() ? "mapped" : "loaded",
+                resourceFile.GetLoadTimeMs(), resourceFile.GetResidentSize() / 1024, resourceFile.GetSize() / 1024);
+    }
+
     FFLiEnableSpecialMii(333326543);
 
     RIO_LOG("[FFLMGR] FFL Avaliable: %d\n", FFLIsAvailable());
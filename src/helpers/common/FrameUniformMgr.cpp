@@ -0,0 +1,132 @@
+#include <helpers/common/FrameUniformMgr.h>
+#include <helpers/common/NodeMgr.h>
+#include <helpers/properties/map/CameraProperty.h>
+#include <gfx/rio_PrimitiveRenderer.h>
+#include <gpu/rio_Drawer.h>
+
+FrameUniformMgr *FrameUniformMgr::mInstance = nullptr;
+
+namespace
+{
+    // Room for a few thousand draws per frame, the ring grows if a frame needs more.
+    const u32 cDrawRingRegionSize = 1024 * 1024;
+}
+
+__attribute__((aligned(rio::Drawer::cUniformBlockAlignment))) FrameUniformMgr::ViewBlock FrameUniformMgr::sViewBlock;
+__attribute__((aligned(rio::Drawer::cUniformBlockAlignment))) FrameUniformMgr::LightBlock FrameUniformMgr::sLightBlock;
+
+bool FrameUniformMgr::createSingleton()
+{
+    if (mInstance)
+        return false;
+
+    mInstance = new FrameUniformMgr();
+
+    sLightBlock.light_color = mInstance->mLightColor;
+    sLightBlock.light_pos = mInstance->mLightPosition;
+
+    mInstance->mpViewUniformBlock = new rio::UniformBlock();
+    mInstance->mpViewUniformBlock->setData(&sViewBlock, sizeof(ViewBlock));
+
+    mInstance->mpLightUniformBlock = new rio::UniformBlock();
+    mInstance->mpLightUniformBlock->setDataInvalidate(&sLightBlock, sizeof(LightBlock));
+
+    // Every mesh draw reads its model block from the ring, there is nothing to draw without it.
+    if (!mInstance->mDrawRing.Initialize(cDrawRingRegionSize))
+    {
+        RIO_LOG("[FRAMEUNIFORMMGR] Failed to create the draw ring.\n");
+        destorySingleton();
+        return false;
+    }
+
+    return true;
+}
+
+bool FrameUniformMgr::destorySingleton()
+{
+    if (!mInstance)
+        return false;
+
+    delete mInstance->mpLightUniformBlock;
+    delete mInstance->mpViewUniformBlock;
+
+    delete mInstance;
+    mInstance = nullptr;
+
+    return true;
+}
+
+CameraProperty *FrameUniformMgr::FindMainCamera() const
+{
+    std::shared_ptr<Node> cameraNode = NodeMgr::instance()->GetNodeByKey("mapCamera");
+    if (!cameraNode)
+        return nullptr;
+
+    PropertySpan<CameraProperty> cameras = cameraNode->GetProperty<CameraProperty>();
+    if (cameras.empty() || !(*cameras.begin())->mInitialized)
+        return nullptr;
+
+    return *cameras.begin();
+}
+
+void FrameUniformMgr::Update()
+{
+    mFrameCount++;
+    mDrawRing.BeginFrame();
+
+    mLastFrameCullStats = mCullStats;
+    mCullStats = {};
+
+    CameraProperty *camera = FindMainCamera();
+
+    mValid = camera != nullptr;
+    if (!mValid)
+        return;
+
+    camera->GetCamera().getMatrix(&mViewMtx);
+    mProjMtx = camera->GetProjectionMatrix();
+
+    // Calculate view-projection matrix (Projection x View)
+    sViewBlock.view_pos = camera->GetParentNode().lock()->GetPosition();
+    sViewBlock.view_proj_mtx.setMul(mProjMtx, mViewMtx);
+    mFrustum.Set(sViewBlock.view_proj_mtx);
+
+    sLightBlock.light_color = mLightColor;
+    sLightBlock.light_pos = mLightPosition;
+
+    mpViewUniformBlock->setSubDataInvalidate(&sViewBlock, 0, sizeof(ViewBlock));
+    mpLightUniformBlock->setSubDataInvalidate(&sLightBlock, 0, sizeof(LightBlock));
+
+    // Its shader is part of rio and takes the camera as plain uniforms, so it gets the same camera instead of the block.
+    rio::PrimitiveRenderer::instance()->setCamera(camera->GetCamera());
+}
+
+void FrameUniformMgr::FinishWrites()
+{
+    mDrawRing.FinishWrites();
+}
+
+void FrameUniformMgr::EndFrame()
+{
+    mDrawRing.EndFrame();
+}
+
+void FrameUniformMgr::SetLight(const rio::Vector3f &pColor, const rio::Vector3f &pPosition)
+{
+    mLightColor = pColor;
+    mLightPosition = pPosition;
+}
+
+void FrameUniformMgr::BindViewBlock(u32 pVSIndex, u32 pFSIndex, rio::UniformBlock::ShaderStage pStage)
+{
+    mpViewUniformBlock->setIndex(pVSIndex, pFSIndex);
+    mpViewUniformBlock->setStage(pStage);
+    mpViewUniformBlock->bind();
+}
+
+void FrameUniformMgr::BindLightBlock(u32 pVSIndex, u32 pFSIndex, rio::UniformBlock::ShaderStage pStage)
+{
+    mpLightUniformBlock->setIndex(pVSIndex, pFSIndex);
+    mpLightUniformBlock->setStage(pStage);
+    mpLightUniformBlock->bind();
+}
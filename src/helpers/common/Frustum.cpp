@@ -0,0 +1,59 @@
+#include <helpers/common/Frustum.h>
+
+#include <cmath>
+
+// Each plane is the last row of the matrix plus or minus one of the others (Gribb and Hartmann).
+// Near is taken for a -w..w depth range, with 0..w depth that only keeps a bit more than needed.
+void Frustum::Set(const rio::BaseMtx44f &pViewProjMtx)
+{
+    const f32 *w = pViewProjMtx.m[3];
+
+    for (u32 axis = 0; axis < 3; axis++)
+    {
+        const f32 *row = pViewProjMtx.m[axis];
+
+        for (u32 side = 0; side < 2; side++)
+        {
+            f32 sign = side == 0 ? 1.f : -1.f;
+            Plane &plane = mPlanes[axis * 2 + side];
+
+            plane.normal = {w[0] + sign * row[0], w[1] + sign * row[1], w[2] + sign * row[2]};
+            plane.distance = w[3] + sign * row[3];
+
+            // Normalized, so sphere radii can be compared against the distance directly.
+            f32 length = std::sqrt(plane.normal.x * plane.normal.x + plane.normal.y * plane.normal.y + plane.normal.z * plane.normal.z);
+            if (length > 0.f)
+            {
+                plane.normal = {plane.normal.x / length, plane.normal.y / length, plane.normal.z / length};
+                plane.distance /= length;
+            }
+        }
+    }
+}
+
+bool Frustum::IsVisible(const BoundingBox &pBox) const
+{
+    for (const Plane &plane : mPlanes)
+    {
+        // The corner furthest along the plane normal, if that one is outside the whole box is.
+        f32 x = plane.normal.x >= 0.f ? pBox.max.x : pBox.min.x;
+        f32 y = plane.normal.y >= 0.f ? pBox.max.y : pBox.min.y;
+        f32 z = plane.normal.z >= 0.f ? pBox.max.z : pBox.min.z;
+
+        if (plane.normal.x * x + plane.normal.y * y + plane.normal.z * z + plane.distance < 0.f)
+            return false;
+    }
+
+    return true;
+}
+
+bool Frustum::IsVisible(const rio::Vector3f &pCenter, f32 pRadius) const
+{
+    for (const Plane &plane : mPlanes)
+    {
+        if (plane.normal.x * pCenter.x + plane.normal.y * pCenter.y + plane.normal.z * pCenter.z + plane.distance < -pRadius)
+            return false;
+    }
+
+    return true;
+}
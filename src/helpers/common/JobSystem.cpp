@@ -0,0 +1,185 @@
+#include <helpers/common/JobSystem.h>
+#include <algorithm>
+
+JobSystem *JobSystem::mInstance = nullptr;
+thread_local u32 JobSystem::sQueueIndex = 0;
+
+bool JobSystem::createSingleton()
+{
+    if (mInstance)
+        return false;
+
+    mInstance = new JobSystem();
+
+    // Leave one core for the thread that owns the singleton, it joins in while waiting anyway.
+    u32 coreCount = std::max(1u, std::thread::hardware_concurrency());
+    mInstance->StartWorkers(coreCount - 1);
+
+    RIO_LOG("[JOBSYSTEM] Started %u worker threads.\n", mInstance->GetWorkerCount());
+
+    return true;
+}
+
+bool JobSystem::destorySingleton()
+{
+    if (!mInstance)
+        return false;
+
+    mInstance->StopWorkers();
+    delete mInstance;
+    mInstance = nullptr;
+
+    return true;
+}
+
+void JobSystem::StartWorkers(u32 pWorkerCount)
+{
+    for (u32 i = 0; i <= pWorkerCount; i++)
+        mQueues.push_back(std::make_unique<JobQueue>());
+
+    mRunning = true;
+
+    for (u32 i = 1; i <= pWorkerCount; i++)
+        mWorkers.emplace_back(&JobSystem::WorkerMain, this, i);
+}
+
+void JobSystem::StopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(mWakeMutex);
+        mRunning = false;
+    }
+
+    mWakeCondition.notify_all();
+
+    for (std::thread &worker : mWorkers)
+        worker.join();
+
+    mWorkers.clear();
+}
+
+void JobSystem::WorkerMain(u32 pQueueIndex)
+{
+    sQueueIndex = pQueueIndex;
+
+    while (mRunning)
+    {
+        if (TryRunJob(pQueueIndex))
+            continue;
+
+        std::unique_lock<std::mutex> lock(mWakeMutex);
+        mWakeCondition.wait(lock, [this]
+                            { return !mRunning || mQueuedJobCount > 0; });
+    }
+}
+
+void JobSystem::Submit(Job pJob, JobCounter *pCounter)
+{
+    if (pCounter)
+        (*pCounter)++;
+
+    // Jobs submitted from threads outside the pool land in queue 0.
+    u32 queueIndex = sQueueIndex < mQueues.size() ? sQueueIndex : 0;
+
+    {
+        std::lock_guard<std::mutex> lock(mQueues[queueIndex]->mutex);
+        mQueues[queueIndex]->jobs.push_back({std::move(pJob), pCounter});
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mWakeMutex);
+        mQueuedJobCount++;
+    }
+
+    mWakeCondition.notify_one();
+}
+
+void JobSystem::Wait(const JobCounter &pCounter)
+{
+    u32 queueIndex = sQueueIndex < mQueues.size() ? sQueueIndex : 0;
+
+    while (pCounter > 0)
+    {
+        if (!TryRunJob(queueIndex))
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::ParallelFor(u32 pCount, u32 pBatchSize, const std::function<void(u32, u32)> &pFunc)
+{
+    if (pCount == 0)
+        return;
+
+    pBatchSize = std::max(1u, pBatchSize);
+
+    // Not worth the hand-off for a single batch.
+    if (pCount <= pBatchSize || mWorkers.empty())
+    {
+        pFunc(0, pCount);
+        return;
+    }
+
+    JobCounter counter{0};
+
+    for (u32 begin = 0; begin < pCount; begin += pBatchSize)
+    {
+        u32 end = std::min(pCount, begin + pBatchSize);
+        Submit([&pFunc, begin, end]
+               { pFunc(begin, end); },
+               &counter);
+    }
+
+    Wait(counter);
+}
+
+bool JobSystem::TryRunJob(u32 pQueueIndex)
+{
+    QueuedJob queuedJob;
+
+    if (!PopJob(pQueueIndex, queuedJob) && !StealJob(pQueueIndex, queuedJob))
+        return false;
+
+    mQueuedJobCount--;
+
+    queuedJob.job();
+
+    if (queuedJob.pCounter)
+        (*queuedJob.pCounter)--;
+
+    return true;
+}
+
+bool JobSystem::PopJob(u32 pQueueIndex, QueuedJob &pJob)
+{
+    JobQueue &queue = *mQueues[pQueueIndex];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+
+    if (queue.jobs.empty())
+        return false;
+
+    pJob = std::move(queue.jobs.back());
+    queue.jobs.pop_back();
+
+    return true;
+}
+
+bool JobSystem::StealJob(u32 pQueueIndex, QueuedJob &pJob)
+{
+    u32 queueCount = mQueues.size();
+
+    for (u32 i = 1; i < queueCount; i++)
+    {
+        JobQueue &queue = *mQueues[(pQueueIndex + i) % queueCount];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        if (queue.jobs.empty())
+            continue;
+
+        pJob = std::move(queue.jobs.front());
+        queue.jobs.pop_front();
+
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,126 @@
+#include <helpers/common/LoadBenchmark.h>
+#include <helpers/common/NodeMgr.h>
+#include <helpers/common/JobSystem.h>
+#include <helpers/common/SceneFile.h>
+#include <filedevice/rio_FileDeviceMgr.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include <yaml-cpp/yaml.h>
+
+namespace
+{
+    const u32 cNodeCounts[] = {1000, 10000, 100000};
+
+    const u32 cRunCount = 3;
+
+    std::string GetMapFolderPath()
+    {
+        return rio::FileDeviceMgr::instance()->getMainFileDevice()->getContentNativePath() + "/map/";
+    }
+}
+
+bool LoadBenchmark::WriteMap(const std::string &pFileName, u32 pNodeCount, bool pBinary)
+{
+    YAML::Emitter out;
+    out << YAML::BeginMap << YAML::Key << "nodes" << YAML::Value << YAML::BeginMap;
+
+    for (u32 i = 0; i < pNodeCount; i++)
+    {
+        s32 id = i + 1;
+        f32 offset = f32(i % 100);
+
+        out << YAML::Key << id << YAML::Value << YAML::BeginMap;
+        out << YAML::Key << "name" << YAML::Value << "benchNode" + std::to_string(id);
+
+        if (i % 4 == 3)
+            out << YAML::Key << "parent" << YAML::Value << id - 1;
+
+        SceneFile::EmitYamlTransform(out, {offset, f32(i / 100), 0.f}, {0.f, offset, 0.f}, {1.f, 1.f, 1.f});
+
+        out << YAML::Key << "properties" << YAML::Value << YAML::BeginMap;
+
+        out << YAML::Key << "Primitive" << YAML::Value << YAML::BeginMap;
+        out << YAML::Key << "shape" << YAML::Value << 1;
+        out << YAML::Key << "color" << YAML::Value << YAML::Flow << YAML::BeginSeq << 1.f << 0.5f << 0.25f << 1.f << YAML::EndSeq;
+        out << YAML::Key << "propertyId" << YAML::Value << 0;
+        out << YAML::EndMap;
+
+        out << YAML::Key << "ExampleEnum" << YAML::Value << YAML::BeginMap;
+        out << YAML::Key << "exampleEnum" << YAML::Value << int(i % 3);
+        out << YAML::Key << "propertyId" << YAML::Value << 1;
+        out << YAML::EndMap;
+
+        out << YAML::EndMap << YAML::EndMap;
+    }
+
+    out << YAML::EndMap << YAML::EndMap;
+
+    std::string path = GetMapFolderPath() + pFileName;
+
+    if (!pBinary)
+        return SceneFile::WriteFile(path, out.c_str(), out.size());
+
+    std::vector<u8> data;
+    if (!SceneFile::ConvertYamlToBinary(YAML::Load(out.c_str()), &data))
+        return false;
+
+    return SceneFile::WriteFile(path, data.data(), data.size());
+}
+
+f32 LoadBenchmark::TimeLoad(const std::string &pFileName, bool pParallel)
+{
+    f32 bestMs = -1.f;
+
+    for (u32 run = 0; run < cRunCount; run++)
+    {
+        NodeMgr::ClearAllNodes();
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        bool loaded = NodeMgr::instance()->LoadFromFile(pFileName, pParallel);
+        f32 elapsedMs = std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        if (!loaded)
+            return -1.f;
+
+        bestMs = bestMs < 0.f ? elapsedMs : std::min(bestMs, elapsedMs);
+    }
+
+    NodeMgr::ClearAllNodes();
+
+    return bestMs;
+}
+
+void LoadBenchmark::Run()
+{
+    if (!JobSystem::instance())
+        RIO_LOG("[BENCHMARK] No job system, parallel loads fall back to sequential ones.\n");
+
+    // Whatever the root task started loading is not part of the measurement.
+    NodeMgr::ClearAllNodes();
+
+    for (u32 nodeCount : cNodeCounts)
+    {
+        for (bool binary : {false, true})
+        {
+            std::string fileName = "benchmark_" + std::to_string(nodeCount) + (binary ? SceneFile::cExtension : ".yaml");
+
+            if (!WriteMap(fileName, nodeCount, binary))
+            {
+                RIO_LOG("[BENCHMARK] Failed to write %s\n", fileName.c_str());
+                continue;
+            }
+
+            f32 sequentialMs = TimeLoad(fileName, false);
+            f32 parallelMs = TimeLoad(fileName, true);
+
+            // Release builds are the ones worth timing, and they don't log.
+            std::printf("[BENCHMARK] %6u nodes, %s: sequential %.2f ms, parallel %.2f ms (%.2fx)\n", nodeCount, binary ? "binary" : "yaml  ",
+                    sequentialMs, parallelMs, parallelMs > 0.f ? sequentialMs / parallelMs : 0.f);
+
+            std::remove((GetMapFolderPath() + fileName).c_str());
+        }
+    }
+}
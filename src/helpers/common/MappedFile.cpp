@@ -0,0 +1,250 @@
+#include <helpers/common/MappedFile.h>
+#include <filedevice/rio_FileDevice.h>
+#include <filedevice/rio_FileDeviceMgr.h>
+#include <misc/rio_MemUtil.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#if RIO_IS_WIN
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#endif // RIO_IS_WIN
+
+std::atomic<size_t> MappedFile::sTotalSize(0);
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Open(const std::string &pPath, u32 pAlignment, bool pCopyOnWrite)
+{
+    Close();
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    mCopyOnWrite = pCopyOnWrite;
+
+    // Empty files can't be mapped, and a failed mapping still leaves the plain load.
+    if (!Map(pPath, pAlignment) && !Load(pPath, pAlignment))
+        return false;
+
+    mLoadTimeMs = std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - start).count();
+    sTotalSize += mSize;
+
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (mpData == nullptr)
+        return;
+
+    sTotalSize -= mSize;
+
+#if RIO_IS_WIN
+    if (mMapped)
+    {
+#if defined(_WIN32)
+        UnmapViewOfFile(mpMapping);
+#else
+        munmap(mpMapping, mMappingSize);
+#endif
+    }
+    else
+#endif // RIO_IS_WIN
+    {
+        rio::MemUtil::free(mpData);
+    }
+
+    mpData = nullptr;
+    mSize = 0;
+    mMapped = false;
+    mpMapping = nullptr;
+    mMappingSize = 0;
+}
+
+bool MappedFile::Load(const std::string &pPath, u32 pAlignment)
+{
+    rio::FileDevice::LoadArg arg;
+    arg.path = pPath;
+    if (pAlignment != 0)
+        arg.alignment = pAlignment;
+
+    u8 *buffer = rio::FileDeviceMgr::instance()->getNativeFileDevice()->tryLoad(arg);
+    if (buffer == nullptr)
+    {
+        RIO_LOG("[MAPPEDFILE] Failed to load %s\n", pPath.c_str());
+        return false;
+    }
+
+    mpData = buffer;
+    mSize = arg.read_size;
+    mMapped = false;
+
+    return true;
+}
+
+#if RIO_IS_WIN && defined(_WIN32)
+
+bool MappedFile::Map(const std::string &pPath, u32 pAlignment)
+{
+    // Views always start on the allocation granularity (64 KiB), which covers every alignment asked for so far.
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    RIO_ASSERT(pAlignment <= systemInfo.dwAllocationGranularity);
+
+    HANDLE file = CreateFileA(pPath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, mCopyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+
+    if (mapping == nullptr)
+        return false;
+
+    // The view keeps the mapping object alive.
+    void *view = MapViewOfFile(mapping, mCopyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+
+    if (view == nullptr)
+        return false;
+
+    mpMapping = view;
+    mMappingSize = size_t(fileSize.QuadPart);
+    mpData = static_cast<u8 *>(view);
+    mSize = mMappingSize;
+    mMapped = true;
+
+    return true;
+}
+
+size_t MappedFile::GetResidentSize() const
+{
+    return mSize;
+}
+
+#elif RIO_IS_WIN
+
+bool MappedFile::Map(const std::string &pPath, u32 pAlignment)
+{
+    int file = open(pPath.c_str(), O_RDONLY);
+    if (file < 0)
+        return false;
+
+    struct stat fileStat;
+    if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0)
+    {
+        close(file);
+        return false;
+    }
+
+    size_t size = size_t(fileStat.st_size);
+    size_t pageSize = size_t(sysconf(_SC_PAGESIZE));
+    size_t alignment = std::max<size_t>(pAlignment, pageSize);
+    int protection = PROT_READ | (mCopyOnWrite ? PROT_WRITE : 0);
+
+    void *mapping = MAP_FAILED;
+    size_t mappingSize = size;
+
+    if (alignment == pageSize)
+    {
+        mapping = mmap(nullptr, size, protection, MAP_PRIVATE, file, 0);
+    }
+    else
+    {
+        // Reserve enough address space to find an aligned start, map the file over it and give back the rest.
+        size_t reserveSize = size + alignment;
+        void *reserve = mmap(nullptr, reserveSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (reserve != MAP_FAILED)
+        {
+            uintptr_t reserveStart = uintptr_t(reserve);
+            uintptr_t alignedStart = (reserveStart + alignment - 1) & ~uintptr_t(alignment - 1);
+            uintptr_t mappedEnd = alignedStart + ((size + pageSize - 1) & ~(pageSize - 1));
+
+            mapping = mmap(reinterpret_cast<void *>(alignedStart), size, protection, MAP_PRIVATE | MAP_FIXED, file, 0);
+
+            if (mapping == MAP_FAILED)
+            {
+                munmap(reserve, reserveSize);
+            }
+            else
+            {
+                if (alignedStart != reserveStart)
+                    munmap(reserve, alignedStart - reserveStart);
+                if (mappedEnd != reserveStart + reserveSize)
+                    munmap(reinterpret_cast<void *>(mappedEnd), reserveStart + reserveSize - mappedEnd);
+            }
+        }
+    }
+
+    close(file);
+
+    if (mapping == MAP_FAILED)
+        return false;
+
+    mpMapping = mapping;
+    mMappingSize = mappingSize;
+    mpData = static_cast<u8 *>(mapping);
+    mSize = size;
+    mMapped = true;
+
+    return true;
+}
+
+size_t MappedFile::GetResidentSize() const
+{
+    if (!mMapped)
+        return mSize;
+
+    size_t pageSize = size_t(sysconf(_SC_PAGESIZE));
+    size_t pageCount = (mMappingSize + pageSize - 1) / pageSize;
+
+#if defined(__APPLE__)
+    std::vector<char> pages(pageCount);
+#else
+    std::vector<unsigned char> pages(pageCount);
+#endif
+
+    if (mincore(mpMapping, mMappingSize, pages.data()) != 0)
+        return mSize;
+
+    size_t residentPages = 0;
+    for (auto page : pages)
+        residentPages += page & 1;
+
+    return std::min(residentPages * pageSize, mSize);
+}
+
+#else
+
+bool MappedFile::Map(const std::string &pPath, u32 pAlignment)
+{
+    return false;
+}
+
+size_t MappedFile::GetResidentSize() const
+{
+    return mSize;
+}
+
+#endif
@@ -0,0 +1,528 @@
+#include <helpers/common/MatrixBatch.h>
+
+#include <cmath>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define MATRIX_BATCH_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MATRIX_BATCH_SSE 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define MATRIX_BATCH_NEON 1
+#endif
+
+namespace
+{
+    // Looks up where the next Count matrices are once, not again for every row.
+    template <u32 Count>
+    inline void GetMatrices(const MatrixBatch::Stream &pStream, u32 pIndex, rio::BaseMtx34f *pOut[Count])
+    {
+        for (u32 i = 0; i < Count; i++)
+            pOut[i] = pStream.Get(pIndex + i);
+    }
+
+    // Every kernel is written once against these, V holds one matrix element of cWidth matrices and M a lane mask.
+    // Matrices are passed as 12 vectors, element [r][c] at index r * 4 + c.
+    // Loads and stores go row by row, the rows are spelled out so the compiler keeps everything in registers.
+    struct ScalarOps
+    {
+        typedef f32 V;
+        typedef bool M;
+
+        static const u32 cWidth = 1;
+
+        static inline V Set(f32 pValue) { return pValue; };
+        static inline V Add(V pA, V pB) { return pA + pB; };
+        static inline V Sub(V pA, V pB) { return pA - pB; };
+        static inline V Mul(V pA, V pB) { return pA * pB; };
+        static inline V Div(V pA, V pB) { return pA / pB; };
+        static inline V Sqrt(V pA) { return std::sqrt(pA); };
+        static inline V Min(V pA, V pB) { return std::fmin(pA, pB); };
+        static inline V Max(V pA, V pB) { return std::fmax(pA, pB); };
+
+        static inline M Equal(V pA, V pB) { return pA == pB; };
+        static inline M NotEqual(V pA, V pB) { return pA != pB; };
+        static inline M Or(M pA, M pB) { return pA || pB; };
+        // pB and not pA.
+        static inline M AndNot(M pA, M pB) { return !pA && pB; };
+        static inline V Select(M pMask, V pA, V pB) { return pMask ? pA : pB; };
+
+        static inline void LoadRow(rio::BaseMtx34f *const pMtx[cWidth], u32 pRow, V pOut[4])
+        {
+            const f32 *row = pMtx[0]->m[pRow];
+            pOut[0] = row[0];
+            pOut[1] = row[1];
+            pOut[2] = row[2];
+            pOut[3] = row[3];
+        };
+
+        static inline void StoreRow(const V pIn[4], rio::BaseMtx34f *const pMtx[cWidth], u32 pRow)
+        {
+            f32 *row = pMtx[0]->m[pRow];
+            row[0] = pIn[0];
+            row[1] = pIn[1];
+            row[2] = pIn[2];
+            row[3] = pIn[3];
+        };
+    };
+
+#if MATRIX_BATCH_AVX
+
+    // The 4x4 transposes work within each 128 bit half, matrices 0-3 go to the low halves and 4-7 to the high ones.
+    struct SimdOps
+    {
+        typedef __m256 V;
+        typedef __m256 M;
+
+        static const u32 cWidth = 8;
+
+        static inline V Set(f32 pValue) { return _mm256_set1_ps(pValue); };
+        static inline V Add(V pA, V pB) { return _mm256_add_ps(pA, pB); };
+        static inline V Sub(V pA, V pB) { return _mm256_sub_ps(pA, pB); };
+        static inline V Mul(V pA, V pB) { return _mm256_mul_ps(pA, pB); };
+        static inline V Div(V pA, V pB) { return _mm256_div_ps(pA, pB); };
+        static inline V Sqrt(V pA) { return _mm256_sqrt_ps(pA); };
+        // Operands in this order return the number if pA is NaN, like fmin() and fmax().
+        static inline V Min(V pA, V pB) { return _mm256_min_ps(pA, pB); };
+        static inline V Max(V pA, V pB) { return _mm256_max_ps(pA, pB); };
+
+        static inline M Equal(V pA, V pB) { return _mm256_cmp_ps(pA, pB, _CMP_EQ_OQ); };
+        static inline M NotEqual(V pA, V pB) { return _mm256_cmp_ps(pA, pB, _CMP_NEQ_UQ); };
+        static inline M Or(M pA, M pB) { return _mm256_or_ps(pA, pB); };
+        static inline M AndNot(M pA, M pB) { return _mm256_andnot_ps(pA, pB); };
+        static inline V Select(M pMask, V pA, V pB) { return _mm256_blendv_ps(pB, pA, pMask); };
+
+        static inline void Transpose(V &pA, V &pB, V &pC, V &pD)
+        {
+            V t0 = _mm256_unpacklo_ps(pA, pB);
+            V t1 = _mm256_unpackhi_ps(pA, pB);
+            V t2 = _mm256_unpacklo_ps(pC, pD);
+            V t3 = _mm256_unpackhi_ps(pC, pD);
+
+            pA = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+            pB = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+            pC = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+            pD = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+        };
+
+        static inline V LoadPair(rio::BaseMtx34f *const pMtx[cWidth], u32 pIndex, u32 pRow)
+        {
+            return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pMtx[pIndex]->m[pRow])), _mm_loadu_ps(pMtx[pIndex + 4]->m[pRow]), 1);
+        };
+
+        static inline void StorePair(V pValue, rio::BaseMtx34f *const pMtx[cWidth], u32 pIndex, u32 pRow)
+        {
+            _mm_storeu_ps(pMtx[pIndex]->m[pRow], _mm256_castps256_ps128(pValue));
+            _mm_storeu_ps(pMtx[pIndex + 4]->m[pRow], _mm256_extractf128_ps(pValue, 1));
+        };
+
+        static inline void LoadRow(rio::BaseMtx34f *const pMtx[cWidth], u32 pRow, V pOut[4])
+        {
+            V a = LoadPair(pMtx, 0, pRow);
+            V b = LoadPair(pMtx, 1, pRow);
+            V c = LoadPair(pMtx, 2, pRow);
+            V d = LoadPair(pMtx, 3, pRow);
+            Transpose(a, b, c, d);
+
+            pOut[0] = a;
+            pOut[1] = b;
+            pOut[2] = c;
+            pOut[3] = d;
+        };
+
+        static inline void StoreRow(const V pIn[4], rio::BaseMtx34f *const pMtx[cWidth], u32 pRow)
+        {
+            V a = pIn[0], b = pIn[1], c = pIn[2], d = pIn[3];
+            Transpose(a, b, c, d);
+
+            StorePair(a, pMtx, 0, pRow);
+            StorePair(b, pMtx, 1, pRow);
+            StorePair(c, pMtx, 2, pRow);
+            StorePair(d, pMtx, 3, pRow);
+        };
+    };
+
+#elif MATRIX_BATCH_SSE
+
+    struct SimdOps
+    {
+        typedef __m128 V;
+        typedef __m128 M;
+
+        static const u32 cWidth = 4;
+
+        static inline V Set(f32 pValue) { return _mm_set1_ps(pValue); };
+        static inline V Add(V pA, V pB) { return _mm_add_ps(pA, pB); };
+        static inline V Sub(V pA, V pB) { return _mm_sub_ps(pA, pB); };
+        static inline V Mul(V pA, V pB) { return _mm_mul_ps(pA, pB); };
+        static inline V Div(V pA, V pB) { return _mm_div_ps(pA, pB); };
+        static inline V Sqrt(V pA) { return _mm_sqrt_ps(pA); };
+        // Operands in this order return the number if pA is NaN, like fmin() and fmax().
+        static inline V Min(V pA, V pB) { return _mm_min_ps(pA, pB); };
+        static inline V Max(V pA, V pB) { return _mm_max_ps(pA, pB); };
+
+        static inline M Equal(V pA, V pB) { return _mm_cmpeq_ps(pA, pB); };
+        static inline M NotEqual(V pA, V pB) { return _mm_cmpneq_ps(pA, pB); };
+        static inline M Or(M pA, M pB) { return _mm_or_ps(pA, pB); };
+        static inline M AndNot(M pA, M pB) { return _mm_andnot_ps(pA, pB); };
+        static inline V Select(M pMask, V pA, V pB) { return _mm_or_ps(_mm_and_ps(pMask, pA), _mm_andnot_ps(pMask, pB)); };
+
+        static inline void LoadRow(rio::BaseMtx34f *const pMtx[cWidth], u32 pRow, V pOut[4])
+        {
+            V a = _mm_loadu_ps(pMtx[0]->m[pRow]);
+            V b = _mm_loadu_ps(pMtx[1]->m[pRow]);
+            V c = _mm_loadu_ps(pMtx[2]->m[pRow]);
+            V d = _mm_loadu_ps(pMtx[3]->m[pRow]);
+            _MM_TRANSPOSE4_PS(a, b, c, d);
+
+            pOut[0] = a;
+            pOut[1] = b;
+            pOut[2] = c;
+            pOut[3] = d;
+        };
+
+        static inline void StoreRow(const V pIn[4], rio::BaseMtx34f *const pMtx[cWidth], u32 pRow)
+        {
+            V a = pIn[0], b = pIn[1], c = pIn[2], d = pIn[3];
+            _MM_TRANSPOSE4_PS(a, b, c, d);
+
+            _mm_storeu_ps(pMtx[0]->m[pRow], a);
+            _mm_storeu_ps(pMtx[1]->m[pRow], b);
+            _mm_storeu_ps(pMtx[2]->m[pRow], c);
+            _mm_storeu_ps(pMtx[3]->m[pRow], d);
+        };
+    };
+
+#elif MATRIX_BATCH_NEON
+
+    struct SimdOps
+    {
+        typedef float32x4_t V;
+        typedef uint32x4_t M;
+
+        static const u32 cWidth = 4;
+
+        static inline V Set(f32 pValue) { return vdupq_n_f32(pValue); };
+        static inline V Add(V pA, V pB) { return vaddq_f32(pA, pB); };
+        static inline V Sub(V pA, V pB) { return vsubq_f32(pA, pB); };
+        static inline V Mul(V pA, V pB) { return vmulq_f32(pA, pB); };
+        static inline V Div(V pA, V pB) { return vdivq_f32(pA, pB); };
+        static inline V Sqrt(V pA) { return vsqrtq_f32(pA); };
+        // The "number" variants ignore a NaN operand, like fmin() and fmax().
+        static inline V Min(V pA, V pB) { return vminnmq_f32(pA, pB); };
+        static inline V Max(V pA, V pB) { return vmaxnmq_f32(pA, pB); };
+
+        static inline M Equal(V pA, V pB) { return vceqq_f32(pA, pB); };
+        static inline M NotEqual(V pA, V pB) { return vmvnq_u32(vceqq_f32(pA, pB)); };
+        static inline M Or(M pA, M pB) { return vorrq_u32(pA, pB); };
+        static inline M AndNot(M pA, M pB) { return vbicq_u32(pB, pA); };
+        static inline V Select(M pMask, V pA, V pB) { return vbslq_f32(pMask, pA, pB); };
+
+        static inline void Transpose(V &pA, V &pB, V &pC, V &pD)
+        {
+            float32x4x2_t ab = vtrnq_f32(pA, pB);
+            float32x4x2_t cd = vtrnq_f32(pC, pD);
+
+            pA = vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0]));
+            pB = vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1]));
+            pC = vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0]));
+            pD = vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1]));
+        };
+
+        static inline void LoadRow(rio::BaseMtx34f *const pMtx[cWidth], u32 pRow, V pOut[4])
+        {
+            V a = vld1q_f32(pMtx[0]->m[pRow]);
+            V b = vld1q_f32(pMtx[1]->m[pRow]);
+            V c = vld1q_f32(pMtx[2]->m[pRow]);
+            V d = vld1q_f32(pMtx[3]->m[pRow]);
+            Transpose(a, b, c, d);
+
+            pOut[0] = a;
+            pOut[1] = b;
+            pOut[2] = c;
+            pOut[3] = d;
+        };
+
+        static inline void StoreRow(const V pIn[4], rio::BaseMtx34f *const pMtx[cWidth], u32 pRow)
+        {
+            V a = pIn[0], b = pIn[1], c = pIn[2], d = pIn[3];
+            Transpose(a, b, c, d);
+
+            vst1q_f32(pMtx[0]->m[pRow], a);
+            vst1q_f32(pMtx[1]->m[pRow], b);
+            vst1q_f32(pMtx[2]->m[pRow], c);
+            vst1q_f32(pMtx[3]->m[pRow], d);
+        };
+    };
+
+#endif
+
+    template <typename S>
+    inline void Load(const MatrixBatch::Stream &pStream, u32 pIndex, typename S::V pOut[12])
+    {
+        rio::BaseMtx34f *mtx[S::cWidth];
+        GetMatrices<S::cWidth>(pStream, pIndex, mtx);
+
+        S::LoadRow(mtx, 0, &pOut[0]);
+        S::LoadRow(mtx, 1, &pOut[4]);
+        S::LoadRow(mtx, 2, &pOut[8]);
+    }
+
+    template <typename S>
+    inline void Store(const typename S::V pIn[12], const MatrixBatch::Stream &pStream, u32 pIndex)
+    {
+        rio::BaseMtx34f *mtx[S::cWidth];
+        GetMatrices<S::cWidth>(pStream, pIndex, mtx);
+
+        S::StoreRow(&pIn[0], mtx, 0);
+        S::StoreRow(&pIn[4], mtx, 1);
+        S::StoreRow(&pIn[8], mtx, 2);
+    }
+
+    template <typename S>
+    inline void SetRow(const f32 pRow[4], typename S::V pOut[4])
+    {
+        pOut[0] = S::Set(pRow[0]);
+        pOut[1] = S::Set(pRow[1]);
+        pOut[2] = S::Set(pRow[2]);
+        pOut[3] = S::Set(pRow[3]);
+    }
+
+    template <typename S>
+    inline void SetBroadcast(const rio::BaseMtx34f &pMtx, typename S::V pOut[12])
+    {
+        SetRow<S>(pMtx.m[0], &pOut[0]);
+        SetRow<S>(pMtx.m[1], &pOut[4]);
+        SetRow<S>(pMtx.m[2], &pOut[8]);
+    }
+
+    template <typename S>
+    inline void MulRow(const typename S::V pA[4], const typename S::V pB[12], typename S::V pOut[4])
+    {
+        pOut[0] = S::Add(S::Add(S::Mul(pA[0], pB[0]), S::Mul(pA[1], pB[4])), S::Mul(pA[2], pB[8]));
+        pOut[1] = S::Add(S::Add(S::Mul(pA[0], pB[1]), S::Mul(pA[1], pB[5])), S::Mul(pA[2], pB[9]));
+        pOut[2] = S::Add(S::Add(S::Mul(pA[0], pB[2]), S::Mul(pA[1], pB[6])), S::Mul(pA[2], pB[10]));
+        pOut[3] = S::Add(S::Add(S::Add(S::Mul(pA[0], pB[3]), S::Mul(pA[1], pB[7])), S::Mul(pA[2], pB[11])), pA[3]);
+    }
+
+    // Same order of operations as rio::Matrix34::setMul().
+    template <typename S>
+    inline void MulKernel(const typename S::V pA[12], const typename S::V pB[12], typename S::V pOut[12])
+    {
+        MulRow<S>(&pA[0], pB, &pOut[0]);
+        MulRow<S>(&pA[4], pB, &pOut[4]);
+        MulRow<S>(&pA[8], pB, &pOut[8]);
+    }
+
+    // Cofactors over the determinant, same order of operations as rio::Matrix34::setInverseTranspose().
+    // That one leaves the output alone for singular matrices, here they become zero.
+    template <typename S>
+    inline void InverseTransposeKernel(const typename S::V pIn[12], typename S::V pOut[12])
+    {
+        typedef typename S::V V;
+
+        V m00 = pIn[0], m01 = pIn[1], m02 = pIn[2];
+        V m10 = pIn[4], m11 = pIn[5], m12 = pIn[6];
+        V m20 = pIn[8], m21 = pIn[9], m22 = pIn[10];
+
+        V det = S::Add(S::Add(S::Mul(S::Mul(m00, m11), m22), S::Mul(S::Mul(m10, m21), m02)), S::Mul(S::Mul(m20, m01), m12));
+        det = S::Sub(det, S::Mul(S::Mul(m20, m11), m02));
+        det = S::Sub(det, S::Mul(S::Mul(m10, m01), m22));
+        det = S::Sub(det, S::Mul(S::Mul(m00, m21), m12));
+
+        V zero = S::Set(0.f);
+        V invDet = S::Select(S::NotEqual(det, zero), S::Div(S::Set(1.f), det), zero);
+
+        pOut[0] = S::Mul(S::Sub(S::Mul(m11, m22), S::Mul(m21, m12)), invDet);
+        pOut[1] = S::Mul(S::Sub(S::Mul(m20, m12), S::Mul(m10, m22)), invDet);
+        pOut[2] = S::Mul(S::Sub(S::Mul(m10, m21), S::Mul(m20, m11)), invDet);
+        pOut[3] = zero;
+
+        pOut[4] = S::Mul(S::Sub(S::Mul(m21, m02), S::Mul(m01, m22)), invDet);
+        pOut[5] = S::Mul(S::Sub(S::Mul(m00, m22), S::Mul(m20, m02)), invDet);
+        pOut[6] = S::Mul(S::Sub(S::Mul(m20, m01), S::Mul(m00, m21)), invDet);
+        pOut[7] = zero;
+
+        pOut[8] = S::Mul(S::Sub(S::Mul(m01, m12), S::Mul(m11, m02)), invDet);
+        pOut[9] = S::Mul(S::Sub(S::Mul(m10, m02), S::Mul(m00, m12)), invDet);
+        pOut[10] = S::Mul(S::Sub(S::Mul(m00, m11), S::Mul(m10, m01)), invDet);
+        pOut[11] = zero;
+    }
+
+    // Normalizes, clamps to [-1, 1] and snaps to the axis once a component reaches 1.
+    template <typename S>
+    inline void SafeNormalize(typename S::V &pX, typename S::V &pY, typename S::V &pZ)
+    {
+        typedef typename S::V V;
+        typedef typename S::M M;
+
+        V magnitude = S::Sqrt(S::Add(S::Add(S::Mul(pX, pX), S::Mul(pY, pY)), S::Mul(pZ, pZ)));
+        M nonZero = S::NotEqual(magnitude, S::Set(0.f));
+
+        pX = S::Select(nonZero, S::Div(pX, magnitude), pX);
+        pY = S::Select(nonZero, S::Div(pY, magnitude), pY);
+        pZ = S::Select(nonZero, S::Div(pZ, magnitude), pZ);
+
+        V one = S::Set(1.f);
+        V minusOne = S::Set(-1.f);
+
+        pX = S::Max(S::Min(pX, one), minusOne);
+        pY = S::Max(S::Min(pY, one), minusOne);
+        pZ = S::Max(S::Min(pZ, one), minusOne);
+
+        M unitX = S::Or(S::Equal(pX, one), S::Equal(pX, minusOne));
+        M unitY = S::AndNot(unitX, S::Or(S::Equal(pY, one), S::Equal(pY, minusOne)));
+        M unitZ = S::AndNot(S::Or(unitX, unitY), S::Or(S::Equal(pZ, one), S::Equal(pZ, minusOne)));
+
+        V zero = S::Set(0.f);
+
+        pX = S::Select(S::Or(unitY, unitZ), zero, pX);
+        pY = S::Select(S::Or(unitX, unitZ), zero, pY);
+        pZ = S::Select(S::Or(unitX, unitY), zero, pZ);
+    }
+
+    template <typename S>
+    inline void OrthonormalizeKernel(typename S::V pMtx[12])
+    {
+        typedef typename S::V V;
+
+        V c0x = pMtx[0], c0y = pMtx[4], c0z = pMtx[8];
+        V c1x = pMtx[1], c1y = pMtx[5], c1z = pMtx[9];
+
+        SafeNormalize<S>(c0x, c0y, c0z);
+        SafeNormalize<S>(c1x, c1y, c1z);
+
+        // Third column from the first two, then the second one again from the third and the first.
+        V c2x = S::Sub(S::Mul(c0y, c1z), S::Mul(c0z, c1y));
+        V c2y = S::Sub(S::Mul(c0z, c1x), S::Mul(c0x, c1z));
+        V c2z = S::Sub(S::Mul(c0x, c1y), S::Mul(c0y, c1x));
+
+        pMtx[0] = c0x;
+        pMtx[4] = c0y;
+        pMtx[8] = c0z;
+
+        pMtx[1] = S::Sub(S::Mul(c2y, c0z), S::Mul(c2z, c0y));
+        pMtx[5] = S::Sub(S::Mul(c2z, c0x), S::Mul(c2x, c0z));
+        pMtx[9] = S::Sub(S::Mul(c2x, c0y), S::Mul(c2y, c0x));
+
+        pMtx[2] = c2x;
+        pMtx[6] = c2y;
+        pMtx[10] = c2z;
+    }
+
+    template <typename S>
+    inline void MulBatch(const rio::BaseMtx34f &pLeft, const MatrixBatch::Stream &pRight, const MatrixBatch::Stream &pOut, u32 pIndex)
+    {
+        typename S::V left[12], right[12], out[12];
+
+        SetBroadcast<S>(pLeft, left);
+        Load<S>(pRight, pIndex, right);
+        MulKernel<S>(left, right, out);
+        Store<S>(out, pOut, pIndex);
+    }
+
+    template <typename S>
+    inline void MulBatch(const MatrixBatch::Stream &pLeft, const MatrixBatch::Stream &pRight, const MatrixBatch::Stream &pOut, u32 pIndex)
+    {
+        typename S::V left[12], right[12], out[12];
+
+        Load<S>(pLeft, pIndex, left);
+        Load<S>(pRight, pIndex, right);
+        MulKernel<S>(left, right, out);
+        Store<S>(out, pOut, pIndex);
+    }
+
+    template <typename S>
+    inline void InverseTransposeBatch(const MatrixBatch::Stream &pIn, const MatrixBatch::Stream &pOut, u32 pIndex)
+    {
+        typename S::V in[12], out[12];
+
+        Load<S>(pIn, pIndex, in);
+        InverseTransposeKernel<S>(in, out);
+        Store<S>(out, pOut, pIndex);
+    }
+
+    template <typename S>
+    inline void OrthonormalizeBatch(const MatrixBatch::Stream &pInOut, u32 pIndex)
+    {
+        typename S::V mtx[12];
+
+        Load<S>(pInOut, pIndex, mtx);
+        OrthonormalizeKernel<S>(mtx);
+        Store<S>(mtx, pInOut, pIndex);
+    }
+
+    template <typename S>
+    inline void ViewNormalBatch(const rio::BaseMtx34f &pView, const MatrixBatch::Stream &pModel, const MatrixBatch::Stream &pModelView,
+                                const MatrixBatch::Stream &pNormal, u32 pIndex)
+    {
+        typename S::V view[12], model[12], modelView[12], normal[12];
+
+        SetBroadcast<S>(pView, view);
+        Load<S>(pModel, pIndex, model);
+        MulKernel<S>(view, model, modelView);
+        Store<S>(modelView, pModelView, pIndex);
+
+        InverseTransposeKernel<S>(modelView, normal);
+        OrthonormalizeKernel<S>(normal);
+        Store<S>(normal, pNormal, pIndex);
+    }
+}
+
+// Full batches go through the SIMD ops, the rest through the scalar ones.
+#if MATRIX_BATCH_AVX || MATRIX_BATCH_SSE || MATRIX_BATCH_NEON
+#define MATRIX_BATCH_FOR_EACH(pCount, pBatch, ...)                              \
+    {                                                                           \
+        u32 index = 0;                                                          \
+        for (; index + SimdOps::cWidth <= pCount; index += SimdOps::cWidth)     \
+            pBatch<SimdOps>(__VA_ARGS__, index);                                \
+        for (; index < pCount; index++)                                         \
+            pBatch<ScalarOps>(__VA_ARGS__, index);                              \
+    }
+#else
+#define MATRIX_BATCH_FOR_EACH(pCount, pBatch, ...)                              \
+    {                                                                           \
+        for (u32 index = 0; index < pCount; index++)                            \
+            pBatch<ScalarOps>(__VA_ARGS__, index);                              \
+    }
+#endif
+
+const char *MatrixBatch::GetInstructionSet()
+{
+#if MATRIX_BATCH_AVX
+    return "AVX";
+#elif MATRIX_BATCH_SSE
+    return "SSE2";
+#elif MATRIX_BATCH_NEON
+    return "NEON";
+#else
+    return "Scalar";
+#endif
+}
+
+void MatrixBatch::Mul(const rio::BaseMtx34f &pLeft, const Stream &pRight, const Stream &pOut, u32 pCount)
+{
+    MATRIX_BATCH_FOR_EACH(pCount, MulBatch, pLeft, pRight, pOut);
+}
+
+void MatrixBatch::Mul(const Stream &pLeft, const Stream &pRight, const Stream &pOut, u32 pCount)
+{
+    MATRIX_BATCH_FOR_EACH(pCount, MulBatch, pLeft, pRight, pOut);
+}
+
+void MatrixBatch::InverseTranspose(const Stream &pIn, const Stream &pOut, u32 pCount)
+{
+    MATRIX_BATCH_FOR_EACH(pCount, InverseTransposeBatch, pIn, pOut);
+}
+
+void MatrixBatch::Orthonormalize(const Stream &pInOut, u32 pCount)
+{
+    MATRIX_BATCH_FOR_EACH(pCount, OrthonormalizeBatch, pInOut);
+}
+
+void MatrixBatch::ViewNormal(const rio::BaseMtx34f &pView, const Stream &pModel, const Stream &pModelView, const Stream &pNormal, u32 pCount)
+{
+    MATRIX_BATCH_FOR_EACH(pCount, ViewNormalBatch, pView, pModel, pModelView, pNormal);
+}
@@ -0,0 +1,200 @@
+#include <helpers/common/MatrixBenchmark.h>
+#include <helpers/common/MatrixBatch.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+namespace
+{
+    const u32 cMatrixCounts[] = {1000, 10000, 100000};
+
+    const u32 cRunCount = 5;
+
+    // Copy of the per-head scalar path Shader::setViewUniform() took before MatrixBatch::ViewNormal(), kept as the reference.
+    void safeNormalizeVec3(rio::BaseVec3f *vec)
+    {
+        float magnitude = std::sqrt(vec->x * vec->x + vec->y * vec->y + vec->z * vec->z);
+        if (magnitude != 0.0f)
+        {
+            vec->x /= magnitude;
+            vec->y /= magnitude;
+            vec->z /= magnitude;
+        }
+
+        vec->x = std::fmax(std::fmin(vec->x, 1.0f), -1.0f);
+        vec->y = std::fmax(std::fmin(vec->y, 1.0f), -1.0f);
+        vec->z = std::fmax(std::fmin(vec->z, 1.0f), -1.0f);
+
+        if (vec->x == 1.0f || vec->x == -1.0f)
+        {
+            vec->y = 0.0f;
+            vec->z = 0.0f;
+        }
+        else if (vec->y == 1.0f || vec->y == -1.0f)
+        {
+            vec->x = 0.0f;
+            vec->z = 0.0f;
+        }
+        else if (vec->z == 1.0f || vec->z == -1.0f)
+        {
+            vec->x = 0.0f;
+            vec->y = 0.0f;
+        }
+    }
+
+    void gramSchmidtOrthonormalizeMtx34(rio::BaseMtx34f *mat)
+    {
+        rio::BaseVec3f c0, c0Normalized, c1, c1Normalized, c1New, c2New;
+
+        // Extract and normalize the first column
+        c0.x = mat->m[0][0];
+        c0.y = mat->m[1][0];
+        c0.z = mat->m[2][0];
+        c0Normalized = c0;
+        safeNormalizeVec3(&c0Normalized);
+
+        // Extract and normalize the second column
+        c1.x = mat->m[0][1];
+        c1.y = mat->m[1][1];
+        c1.z = mat->m[2][1];
+        c1Normalized = c1;
+        safeNormalizeVec3(&c1Normalized);
+
+        // Compute the third column as the cross product of the first two normalized columns
+        c2New.x = c0Normalized.y * c1Normalized.z - c0Normalized.z * c1Normalized.y;
+        c2New.y = c0Normalized.z * c1Normalized.x - c0Normalized.x * c1Normalized.z;
+        c2New.z = c0Normalized.x * c1Normalized.y - c0Normalized.y * c1Normalized.x;
+
+        // Compute the new second column as the cross product of the third column and the first normalized column
+        c1New.x = c2New.y * c0Normalized.z - c2New.z * c0Normalized.y;
+        c1New.y = c2New.z * c0Normalized.x - c2New.x * c0Normalized.z;
+        c1New.z = c2New.x * c0Normalized.y - c2New.y * c0Normalized.x;
+
+        // Update the matrix with the new orthonormal columns
+        mat->m[0][0] = c0Normalized.x;
+        mat->m[1][0] = c0Normalized.y;
+        mat->m[2][0] = c0Normalized.z;
+
+        mat->m[0][1] = c1New.x;
+        mat->m[1][1] = c1New.y;
+        mat->m[2][1] = c1New.z;
+
+        mat->m[0][2] = c2New.x;
+        mat->m[1][2] = c2New.y;
+        mat->m[2][2] = c2New.z;
+    }
+
+    void calcViewNormal(const rio::Matrix34f &view_mtx, const rio::Matrix34f &model_mtx, rio::Matrix34f *p_mv, rio::Matrix34f *p_it)
+    {
+        p_mv->setMul(view_mtx, model_mtx);
+
+        *p_it = *p_mv;
+        p_it->setInverseTranspose(*p_mv);
+        gramSchmidtOrthonormalizeMtx34(p_it);
+    }
+
+    void PrintResult(const char *pName, u32 pCount, f32 pScalarMs, f32 pBatchMs, f32 pMaxDifference)
+    {
+        // Release builds are the ones worth timing, and they don't log.
+        std::printf("[BENCHMARK] %6u matrices, %-15s scalar %7.3f ms, batch %7.3f ms (%.2fx), max difference %g\n", pCount, pName, pScalarMs, pBatchMs,
+                    pBatchMs > 0.f ? pScalarMs / pBatchMs : 0.f, pMaxDifference);
+    }
+}
+
+void MatrixBenchmark::MakeMatrices(MatrixList *pOut, u32 pCount, u32 pSeed)
+{
+    std::mt19937 random(pSeed);
+    std::uniform_real_distribution<f32> position(-100.f, 100.f);
+    std::uniform_real_distribution<f32> rotation(-3.14159f, 3.14159f);
+    std::uniform_real_distribution<f32> scale(0.25f, 4.f);
+
+    pOut->resize(pCount);
+
+    for (rio::Matrix34f &mtx : *pOut)
+    {
+        mtx.makeSRT({scale(random), scale(random), scale(random)}, {rotation(random), rotation(random), rotation(random)},
+                    {position(random), position(random), position(random)});
+    }
+}
+
+f32 MatrixBenchmark::GetMaxDifference(const MatrixList &pA, const MatrixList &pB)
+{
+    f32 maxDifference = 0.f;
+
+    for (u32 i = 0; i < pA.size(); i++)
+    {
+        for (u32 j = 0; j < 12; j++)
+            maxDifference = std::max(maxDifference, std::fabs(pA[i].m[j / 4][j % 4] - pB[i].m[j / 4][j % 4]));
+    }
+
+    return maxDifference;
+}
+
+template <typename Func>
+f32 MatrixBenchmark::Time(Func pFunc)
+{
+    f32 bestMs = -1.f;
+
+    for (u32 run = 0; run < cRunCount; run++)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        pFunc();
+        f32 elapsedMs = std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        bestMs = bestMs < 0.f ? elapsedMs : std::min(bestMs, elapsedMs);
+    }
+
+    return bestMs;
+}
+
+void MatrixBenchmark::Run()
+{
+    std::printf("[BENCHMARK] Matrix batches run on %s\n", MatrixBatch::GetInstructionSet());
+
+    rio::Matrix34f viewMtx;
+    viewMtx.makeSRT({1.f, 1.f, 1.f}, {0.3f, -0.8f, 0.f}, {10.f, -20.f, 300.f});
+
+    for (u32 count : cMatrixCounts)
+    {
+        MatrixList parents, locals;
+        MakeMatrices(&parents, count, 1);
+        MakeMatrices(&locals, count, 2);
+
+        MatrixList scalar(count), batch(count), scalarNormal(count), batchNormal(count);
+
+        // World matrices, what TransformStore does for every child transform.
+        f32 scalarMs = Time([&]()
+                            {
+                                for (u32 i = 0; i < count; i++)
+                                    scalar[i].setMul(parents[i], locals[i]);
+                            });
+        f32 batchMs = Time([&]()
+                           { MatrixBatch::Mul(MatrixBatch::Stream(parents.data(), sizeof(rio::Matrix34f)), MatrixBatch::Stream(locals.data(), sizeof(rio::Matrix34f)),
+                                              MatrixBatch::Stream(batch.data(), sizeof(rio::Matrix34f)), count); });
+        PrintResult("world:", count, scalarMs, batchMs, GetMaxDifference(scalar, batch));
+
+        // Normal matrices, what MeshProperty uploads per mesh.
+        scalarMs = Time([&]()
+                        {
+                            for (u32 i = 0; i < count; i++)
+                                scalar[i].setInverseTranspose(parents[i]);
+                        });
+        batchMs = Time([&]()
+                       { MatrixBatch::InverseTranspose(MatrixBatch::Stream(parents.data(), sizeof(rio::Matrix34f)), MatrixBatch::Stream(batch.data(), sizeof(rio::Matrix34f)), count); });
+        PrintResult("normal:", count, scalarMs, batchMs, GetMaxDifference(scalar, batch));
+
+        // Mii modelview and normal matrix, the old per-head path against all heads at once.
+        scalarMs = Time([&]()
+                        {
+                            for (u32 i = 0; i < count; i++)
+                                calcViewNormal(viewMtx, parents[i], &scalar[i], &scalarNormal[i]);
+                        });
+        batchMs = Time([&]()
+                       { MatrixBatch::ViewNormal(viewMtx, MatrixBatch::Stream(parents.data(), sizeof(rio::Matrix34f)), MatrixBatch::Stream(batch.data(), sizeof(rio::Matrix34f)),
+                                                 MatrixBatch::Stream(batchNormal.data(), sizeof(rio::Matrix34f)), count); });
+        PrintResult("mii view:", count, scalarMs, batchMs, std::max(GetMaxDifference(scalar, batch), GetMaxDifference(scalarNormal, batchNormal)));
+    }
+}
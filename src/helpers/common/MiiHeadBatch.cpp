@@ -0,0 +1,291 @@
+#include <helpers/common/MiiHeadBatch.h>
+#include <helpers/common/MatrixBatch.h>
+#include <gpu/rio_RenderState.h>
+#include <gfx/rio_Window.h>
+#include <misc/rio_MemUtil.h>
+
+#include <algorithm>
+#include <bitset>
+#include <chrono>
+#include <cstring>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    // The upper bits of FFLResolution are flags, not part of the size.
+    const u32 cResolutionMask = 0x3fffffff;
+
+    // Shapes are small next to the textures, a fixed guess is close enough.
+    const size_t cShapeMemorySize = 512 * 1024;
+
+    // 64 bit FNV-1a.
+    inline u64 HashBytes(const void *pData, size_t pSize, u64 pHash = 14695981039346656037ull)
+    {
+        const u8 *bytes = static_cast<const u8 *>(pData);
+        for (size_t i = 0; i < pSize; i++)
+        {
+            pHash ^= bytes[i];
+            pHash *= 1099511628211ull;
+        }
+
+        return pHash;
+    }
+
+    inline f32 GetElapsedMs(Clock::time_point pStart)
+    {
+        return std::chrono::duration<f32, std::milli>(Clock::now() - pStart).count();
+    }
+}
+
+size_t MiiHeadBatch::KeyHash::operator()(const Key &pKey) const
+{
+    u64 hash = pKey.storeDataHash;
+    hash = HashBytes(&pKey.resolution, sizeof(u32), hash);
+    hash = HashBytes(&pKey.expressionFlag, sizeof(u32), hash);
+    hash = HashBytes(&pKey.resourceType, sizeof(u32), hash);
+    hash = HashBytes(&pKey.modelFlag, sizeof(u32), hash);
+
+    return size_t(hash);
+}
+
+MiiHeadBatch::Key MiiHeadBatch::MakeKey(const FFLStoreData &pStoreData, const FFLCharModelDesc &pDesc)
+{
+    Key key;
+    key.storeDataHash = HashBytes(&pStoreData, sizeof(FFLStoreData));
+    key.resolution = u32(pDesc.resolution);
+    key.expressionFlag = pDesc.expressionFlag;
+    key.resourceType = u32(pDesc.resourceType);
+    key.modelFlag = pDesc.modelFlag;
+
+    return key;
+}
+
+MiiHeadBatch::MiiHeadBatch(const FFLStoreData &pStoreData, const FFLCharModelDesc &pDesc)
+    : mKey(MakeKey(pStoreData, pDesc))
+{
+    rio::MemUtil::copy(&mStoreData, &pStoreData, sizeof(FFLStoreData));
+
+    mCharModelSource.dataSource = FFL_DATA_SOURCE_STORE_DATA;
+    mCharModelSource.pBuffer = &mStoreData;
+    mCharModelSource.index = 0;
+
+    mCharModelDesc = pDesc;
+}
+
+MiiHeadBatch::~MiiHeadBatch()
+{
+    if (!mInitialized)
+        return;
+
+    // The shader keeps the uploaded vertex buffers of the CharModel, they have to go before FFL frees its shapes.
+    mpShader->invalidateCharModel(&mCharModel);
+    FFLDeleteCharModel(&mCharModel);
+
+#if RIO_IS_WIN
+    if (mInstanceVBOHandle != GL_NONE)
+        RIO_GL_CALL(glDeleteBuffers(1, &mInstanceVBOHandle));
+#endif
+}
+
+// FFLInitCharModelCPUStep allocates the face textures and reads from the shared FFL resource file,
+// so this has to run on the GL thread.
+bool MiiHeadBatch::Initialize(Shader *pShader)
+{
+    mpShader = pShader;
+
+    Clock::time_point start = Clock::now();
+
+    if (FFLInitCharModelCPUStep(&mCharModel, &mCharModelSource, &mCharModelDesc) != FFL_RESULT_OK)
+    {
+        RIO_LOG("[MIIHEAD] InitCharModelCPUStep failed!!\n");
+        return false;
+    }
+
+    mCPUStepTimeMs = GetElapsedMs(start);
+    start = Clock::now();
+
+    // Unsets the current CharModel too, so the face texture draws of the GPU step don't end up cached.
+    mpShader->bind(false);
+    mpShader->invalidateCharModel(&mCharModel);
+
+    FFLInitCharModelGPUStep(&mCharModel);
+    rio::Window::instance()->makeContextCurrent();
+
+    mGPUStepTimeMs = GetElapsedMs(start);
+
+    FFLBoundingBox boundingBox;
+    FFLGetBoundingBox(&mCharModel, &boundingBox);
+
+    mBounds.Add(rio::Vector3f{boundingBox.min.x, boundingBox.min.y, boundingBox.min.z});
+    mBounds.Add(rio::Vector3f{boundingBox.max.x, boundingBox.max.y, boundingBox.max.z});
+
+    mInitialized = true;
+    return true;
+}
+
+bool MiiHeadBatch::Matches(const FFLStoreData &pStoreData) const
+{
+    return std::memcmp(&mStoreData, &pStoreData, sizeof(FFLStoreData)) == 0;
+}
+
+// The faceline texture is half as wide as it is high, every expression gets its own square mask texture, both RGBA8.
+size_t MiiHeadBatch::GetMemorySize() const
+{
+    size_t resolution = u32(mCharModelDesc.resolution) & cResolutionMask;
+    size_t expressionCount = std::bitset<32>(mCharModelDesc.expressionFlag).count();
+
+    size_t facelineSize = (resolution / 2) * resolution * 4;
+    size_t maskSize = resolution * resolution * 4;
+
+    return facelineSize + maskSize * expressionCount + cShapeMemorySize;
+}
+
+void MiiHeadBatch::AddInstance(const rio::BaseMtx34f *pModelMtx)
+{
+    mInstances.push_back(pModelMtx);
+}
+
+void MiiHeadBatch::RemoveInstance(const rio::BaseMtx34f *pModelMtx)
+{
+    auto it = std::find(mInstances.begin(), mInstances.end(), pModelMtx);
+    if (it != mInstances.end())
+        mInstances.erase(it);
+}
+
+// Both platforms need the normal matrices too, GL streams them with the modelviews as instance attributes.
+void MiiHeadBatch::UpdateInstanceMatrices(const rio::BaseMtx34f &pViewMtx, const Frustum *pFrustum)
+{
+    mVisibleInstances.clear();
+
+    for (const rio::BaseMtx34f *instance : mInstances)
+    {
+        if (!pFrustum || mBounds.IsEmpty() || pFrustum->IsVisible(mBounds.Transform(*instance)))
+            mVisibleInstances.push_back(instance);
+    }
+
+    u32 count = mVisibleInstances.size();
+    mModelViewMtx.resize(count);
+    mNormalMtx.resize(count);
+
+    MatrixBatch::ViewNormal(pViewMtx, MatrixBatch::Stream(mVisibleInstances.data()), MatrixBatch::Stream(mModelViewMtx.data(), sizeof(rio::Matrix34f)),
+                            MatrixBatch::Stream(mNormalMtx.data(), sizeof(rio::Matrix34f)), count);
+}
+
+#if RIO_IS_WIN
+
+void MiiHeadBatch::UpdateInstanceBuffer()
+{
+    mInstanceData.resize(mVisibleInstances.size());
+
+    for (u32 i = 0; i < mVisibleInstances.size(); i++)
+        Shader::calcInstanceData(&mInstanceData[i], mModelViewMtx[i], mNormalMtx[i]);
+
+    if (mInstanceVBOHandle == GL_NONE)
+        RIO_GL_CALL(glCreateBuffers(1, &mInstanceVBOHandle));
+
+    RIO_GL_CALL(glNamedBufferData(mInstanceVBOHandle, mInstanceData.size() * sizeof(Shader::InstanceData), mInstanceData.data(), GL_STREAM_DRAW));
+}
+
+#endif // RIO_IS_WIN
+
+void MiiHeadBatch::BindShader(u32 pInstance, const rio::BaseMtx44f &pProjMtx)
+{
+    mpShader->bind(true);
+    mpShader->setCharModel(&mCharModel);
+    mpShader->setProjUniform(pProjMtx);
+
+#if RIO_IS_WIN
+    mpShader->setInstanceBuffer(mInstanceVBOHandle, mVisibleInstances.size());
+#else
+    mpShader->setModelViewUniform(mModelViewMtx[pInstance], mNormalMtx[pInstance]);
+#endif
+}
+
+void MiiHeadBatch::DrawOpa(const rio::BaseMtx34f &pViewMtx, const rio::BaseMtx44f &pProjMtx, const Frustum *pFrustum)
+{
+    UpdateInstanceMatrices(pViewMtx, pFrustum);
+
+    if (mVisibleInstances.empty())
+        return;
+
+#if RIO_IS_WIN
+    UpdateInstanceBuffer();
+    BindShader(0, pProjMtx);
+    DrawOpaPass();
+#else
+    for (u32 i = 0; i < mVisibleInstances.size(); i++)
+    {
+        BindShader(i, pProjMtx);
+        DrawOpaPass();
+    }
+#endif
+}
+
+// Every other opaque draw happens in between, so the shader and matrices have to be bound again.
+// The matrices themselves are still the ones from DrawOpa().
+void MiiHeadBatch::DrawXlu(const rio::BaseMtx34f &pViewMtx, const rio::BaseMtx44f &pProjMtx)
+{
+    if (mVisibleInstances.empty())
+        return;
+
+#if RIO_IS_WIN
+    BindShader(0, pProjMtx);
+    DrawXluPass();
+#else
+    for (u32 i = 0; i < mVisibleInstances.size(); i++)
+    {
+        BindShader(i, pProjMtx);
+        DrawXluPass();
+    }
+#endif
+}
+
+void MiiHeadBatch::DrawOpaPass()
+{
+    rio::RenderState render_state;
+    render_state.setDepthEnable(true, true);
+    render_state.setDepthFunc(rio::Graphics::COMPARE_FUNC_LEQUAL);
+    render_state.setBlendEnable(false);
+    render_state.setColorMask(true, true, true, true);
+    render_state.apply();
+
+    FFLDrawOpa(&mCharModel);
+}
+
+void MiiHeadBatch::DrawXluPass()
+{
+    {
+        rio::RenderState render_state;
+        render_state.setDepthEnable(true, false);
+        render_state.setDepthFunc(rio::Graphics::COMPARE_FUNC_LEQUAL);
+        render_state.setBlendEnable(true);
+        render_state.setBlendFactorSrcRGB(rio::Graphics::BLEND_MODE_SRC_ALPHA);
+        render_state.setBlendFactorDstRGB(rio::Graphics::BLEND_MODE_ONE_MINUS_SRC_ALPHA);
+        render_state.setBlendEquation(rio::Graphics::BLEND_FUNC_ADD);
+        render_state.setColorMask(true, true, true, false);
+        render_state.apply();
+
+        mpShader->applyAlphaTestEnable();
+
+        FFLDrawXlu(&mCharModel);
+    }
+
+    {
+        rio::RenderState render_state;
+        render_state.setDepthEnable(true, true);
+        render_state.setDepthFunc(rio::Graphics::COMPARE_FUNC_LEQUAL);
+        render_state.setBlendEnable(true);
+        render_state.setBlendFactorSrcRGB(rio::Graphics::BLEND_MODE_ONE_MINUS_DST_ALPHA);
+        render_state.setBlendFactorDstRGB(rio::Graphics::BLEND_MODE_DST_ALPHA);
+        render_state.setBlendFactorSrcAlpha(rio::Graphics::BLEND_MODE_ONE);
+        render_state.setBlendFactorDstAlpha(rio::Graphics::BLEND_MODE_ONE);
+        render_state.setBlendEquation(rio::Graphics::BLEND_FUNC_ADD);
+        render_state.setColorMask(true, true, true, true);
+        render_state.apply();
+
+        mpShader->applyAlphaTestEnable();
+
+        FFLDrawXlu(&mCharModel);
+    }
+}
@@ -5,31 +5,135 @@
 #include <imgui.h>
 #include <misc/cpp/imgui_stdlib.h>
 
+namespace
+{
+    // Nodes that draw nothing still need a box to be found by position.
+    const f32 cEmptyBoundsHalfSize = 0.5f;
+}
+
 Node::Node(std::string pNodeKey, rio::Vector3f pPos, rio::Vector3f pRot, rio::Vector3f pScale)
 {
     nodeKey = pNodeKey;
 
-    mPosition = pPos;
-    mRotation = pRot;
-    mScale = pScale;
+    mpTransformStore = &NodeMgr::instance()->GetTransformStore();
+    mTransformHandle = mpTransformStore->Create(pPos, pRot, pScale);
 
-    transformMatrix.makeSRT(mPosition, mRotation, mScale);
-    ID = NodeMgr::instance()->GetNodeCount() + 1;
+    ID = NodeMgr::instance()->AcquireNodeID();
 
     RIO_LOG("[NODE] New node created with key: %s.\n", nodeKey.c_str());
 };
 
+Node::~Node()
+{
+    if (mRegisteredInNodeMgr && NodeMgr::instance())
+        NodeMgr::instance()->UnregisterProperties(this);
+
+    properties.clear();
+
+    mpTransformStore->Destroy(mTransformHandle);
+    mTransformHandle = TransformStore::cInvalidHandle;
+}
+
+bool Node::SetParent(std::shared_ptr<Node> pParent)
+{
+    TransformStore::Handle parentHandle = pParent ? pParent->GetTransformHandle() : TransformStore::cInvalidHandle;
+
+    if (!mpTransformStore->SetParent(mTransformHandle, parentHandle))
+        return false;
+
+    mParent = pParent;
+    MarkSaveDirty();
+    return true;
+}
+
+BoundingBox Node::GetWorldBounds()
+{
+    BoundingBox bounds;
+
+    for (auto &property : properties)
+    {
+        if (property->mInitialized)
+            bounds.Merge(property->GetWorldBounds());
+    }
+
+    if (bounds.IsEmpty())
+        bounds = BoundingBox::FromCenter(GetWorldPosition(), {cEmptyBoundsHalfSize, cEmptyBoundsHalfSize, cEmptyBoundsHalfSize});
+
+    return bounds;
+}
+
+void Node::MarkBoundsDirty()
+{
+    if (mRegisteredInNodeMgr && NodeMgr::instance())
+        NodeMgr::instance()->OnNodeBoundsChanged(this);
+}
+
+bool Node::IsSaveDirty() const
+{
+    if (mSaveDirty)
+        return true;
+
+    for (auto &property : properties)
+    {
+        if (property->IsDirty())
+            return true;
+    }
+
+    return false;
+}
+
 bool Node::AddProperty(std::unique_ptr<Property> pProperty)
 {
+    if (!pProperty)
+        return false;
+
+    Property *property = pProperty.get();
+
     properties.push_back(std::move(pProperty));
+    mPropertiesByType[property->GetPropertyType()].push_back(property);
+    MarkSaveDirty();
+
+    if (mRegisteredInNodeMgr)
+    {
+        NodeMgr::instance()->RegisterProperty(property);
+        MarkBoundsDirty();
+    }
+
     return true;
 }
 
 void Node::CreateNodeProperties()
 {
+    std::string oldNodeKey = nodeKey;
+
     ImGui::PushID("nodeKey");
     ImGui::PushItemWidth(ImGui::GetContentRegionAvail().x);
-    ImGui::InputText("", &nodeKey);
+    if (ImGui::InputText("", &nodeKey))
+        NodeMgr::instance()->OnNodeKeyChanged(this, oldNodeKey);
+    ImGui::PopID();
+
+    std::shared_ptr<Node> parentNode = GetParent();
+
+    ImGui::Text("Parent");
+    ImGui::PushID("parent");
+    if (ImGui::BeginCombo("", parentNode ? parentNode->nodeKey.c_str() : "None"))
+    {
+        if (ImGui::Selectable("None", !parentNode))
+            SetParent(nullptr);
+
+        for (const auto &node : NodeMgr::instance()->mNodes)
+        {
+            if (node.get() == this)
+                continue;
+
+            ImGui::PushID(node->ID);
+            if (ImGui::Selectable(node->nodeKey.c_str(), node == parentNode))
+                SetParent(node);
+            ImGui::PopID();
+        }
+
+        ImGui::EndCombo();
+    }
     ImGui::PopID();
 
     rio::Vector3f positionVector = GetPosition();
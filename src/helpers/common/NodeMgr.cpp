@@ -3,6 +3,9 @@
 #include <gfx/rio_Color.h>
 
 #include <helpers/common/NodeMgr.h>
+#include <helpers/common/FrameUniformMgr.h>
+#include <helpers/common/JobSystem.h>
+#include <helpers/common/MappedFile.h>
 #include <helpers/model/LightNode.h>
 #include <helpers/model/ModelNode.h>
 #include <helpers/common/Node.h>
@@ -10,6 +13,8 @@
 
 #include <gfx/rio_PrimitiveRenderer.h>
 
+#include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <vector>
 #include <memory>
@@ -22,6 +27,34 @@
 
 NodeMgr *NodeMgr::mInstance = nullptr;
 
+namespace
+{
+    // Matches the hand written maps.
+    const u32 cYamlIndent = 4;
+
+    // Update phases, run in this order every frame. Each phase walks every property of one type before moving to the next.
+    // Cameras go first so the rest of the frame sees the current view.
+    const PropertyType cCameraPhase[] = {PROPERTY_TYPE_CAMERA};
+    // Only types that actually override Property::UpdateAsync(). Fanned out across the job system after the camera phase.
+    const PropertyType cAsyncPhase[] = {PROPERTY_TYPE_MESH, PROPERTY_TYPE_MII_HEAD};
+    const PropertyType cLogicPhase[] = {PROPERTY_TYPE_UNKNOWN, PROPERTY_TYPE_AUDIO, PROPERTY_TYPE_EXAMPLE, PROPERTY_TYPE_EXAMPLE_ENUM};
+    const PropertyType cOpaquePhase[] = {PROPERTY_TYPE_PRIMITIVE, PROPERTY_TYPE_MESH, PROPERTY_TYPE_MII_HEAD};
+    // Only types that actually override Property::DrawXlu().
+    const PropertyType cTranslucentPhase[] = {PROPERTY_TYPE_MII_HEAD};
+
+    // Only types that actually override Property::StartAsync().
+    const PropertyType cAsyncStartPhase[] = {PROPERTY_TYPE_MII_HEAD};
+
+    // Properties per job, keeps the hand-off cost small next to the work itself.
+    const u32 cAsyncBatchSize = 8;
+
+    // Nodes read per job by a parallel load.
+    const u32 cLoadBatchSize = 64;
+
+    // Properties started together by a streaming load, their StartAsync() calls run in parallel.
+    const u32 cStreamingStartBatchSize = 8;
+}
+
 bool NodeMgr::createSingleton()
 {
     if (mInstance)
@@ -45,6 +78,7 @@ bool NodeMgr::destorySingleton()
     if (!mInstance)
         return false;
 
+    mInstance->WaitForSave();
     mInstance->ClearAllNodes();
     delete mInstance;
     mInstance = nullptr;
@@ -54,20 +88,63 @@ bool NodeMgr::destorySingleton()
 
 bool NodeMgr::DeleteNode(const int pIndex)
 {
-    if (pIndex < 0 || pIndex > mInstance->mNodes.size())
+    if (pIndex < 0 || pIndex >= mInstance->mNodes.size())
         return false;
 
+    std::shared_ptr<Node> node = mInstance->mNodes.at(pIndex);
+
+    // The node can outlive this while the editor still holds it, its children must not keep following it
+    // or be saved with a parent that is no longer in the scene. They keep their local transform.
+    for (auto &child : mInstance->mNodes)
+    {
+        if (child->GetParent() == node)
+            child->SetParent(nullptr);
+    }
+
+    mInstance->UnindexNode(node);
+    mInstance->RemoveFromSpatialIndex(node.get());
+    mInstance->UnregisterProperties(node.get());
     mInstance->mNodes.erase(mInstance->mNodes.begin() + pIndex);
 
     return true;
 }
 
+void NodeMgr::ClearAllNodes()
+{
+    // Whatever is left of a streaming load belonged to the old scene.
+    mInstance->mpStreamingLoad.reset();
+
+    mInstance->mNodeKeyIndex.clear();
+    mInstance->mNodeIDIndex.clear();
+    mInstance->mNextNodeID = 1;
+
+    // Dropping the whole registry and spatial index at once is cheaper than going node by node.
+    for (auto &node : mInstance->mNodes)
+    {
+        node->mRegisteredInNodeMgr = false;
+        node->mSpatialProxy = BoundingVolumeTree::cNullProxy;
+        node->mSpatialDirty = false;
+    }
+
+    mInstance->mSpatialIndex.Clear();
+    mInstance->mNodesByHandle.clear();
+    mInstance->mSpatialDirtyNodes.clear();
+
+    for (auto &typed : mInstance->mPropertiesByType)
+        typed.clear();
+
+    mInstance->mNodes.clear();
+}
+
 int NodeMgr::AddNode(std::shared_ptr<Node> pNode)
 {
     if (!pNode)
         return -1;
 
     mInstance->mNodes.push_back(pNode);
+    mInstance->IndexNode(pNode);
+    mInstance->RegisterProperties(pNode.get());
+    mInstance->AddToSpatialIndex(pNode.get());
     RIO_LOG("[NODEMGR] Added %s to NodeMgr.\n", pNode->nodeKey.c_str());
 
     return mInstance->mNodes.size() - 1;
@@ -80,137 +157,822 @@ Node *NodeMgr::GetNodeByIndex(const int pIndex)
 
 std::shared_ptr<Node> NodeMgr::GetNodeByKey(const char *pKey)
 {
-    for (const auto &node : mNodes)
+    auto it = mNodeKeyIndex.find(pKey);
+    if (it == mNodeKeyIndex.end() || it->second.empty())
+        return nullptr;
+
+    return it->second.front();
+}
+
+Node *NodeMgr::GetNodeByID(const int ID)
+{
+    auto it = mNodeIDIndex.find(ID);
+    if (it == mNodeIDIndex.end() || it->second.empty())
+        return nullptr;
+
+    return it->second.front().get();
+}
+
+void NodeMgr::OnNodeKeyChanged(Node *pNode, const std::string &pOldKey)
+{
+    pNode->MarkSaveDirty();
+
+    auto it = mNodeKeyIndex.find(pOldKey);
+    if (it == mNodeKeyIndex.end())
+        return;
+
+    std::vector<std::shared_ptr<Node>> &bucket = it->second;
+
+    for (auto nodeIt = bucket.begin(); nodeIt != bucket.end(); ++nodeIt)
     {
-        if (strcmp(node.get()->nodeKey.c_str(), pKey) == 0)
-            return node;
+        if (nodeIt->get() != pNode)
+            continue;
+
+        std::shared_ptr<Node> node = *nodeIt;
+        bucket.erase(nodeIt);
+
+        if (bucket.empty())
+            mNodeKeyIndex.erase(it);
+
+        mNodeKeyIndex[node->nodeKey].push_back(node);
+        return;
     }
+}
 
-    return nullptr;
+void NodeMgr::RegisterProperty(Property *pProperty)
+{
+    mPropertiesByType[pProperty->GetPropertyType()].push_back(pProperty);
 }
 
-Node *NodeMgr::GetNodeByID(const int ID)
+void NodeMgr::RegisterProperties(Node *pNode)
+{
+    for (auto &property : pNode->properties)
+        RegisterProperty(property.get());
+
+    pNode->mRegisteredInNodeMgr = true;
+}
+
+void NodeMgr::UnregisterProperties(Node *pNode)
+{
+    for (auto &property : pNode->properties)
+    {
+        std::vector<Property *> &typed = mPropertiesByType[property->GetPropertyType()];
+
+        auto it = std::find(typed.begin(), typed.end(), property.get());
+        if (it != typed.end())
+            typed.erase(it);
+    }
+
+    pNode->mRegisteredInNodeMgr = false;
+}
+
+void NodeMgr::IndexNode(const std::shared_ptr<Node> &pNode)
+{
+    mNodeKeyIndex[pNode->nodeKey].push_back(pNode);
+    mNodeIDIndex[pNode->ID].push_back(pNode);
+    mNextNodeID = std::max(mNextNodeID, pNode->ID + 1);
+}
+
+void NodeMgr::UnindexNode(const std::shared_ptr<Node> &pNode)
+{
+    auto keyIt = mNodeKeyIndex.find(pNode->nodeKey);
+    if (keyIt != mNodeKeyIndex.end())
+    {
+        std::vector<std::shared_ptr<Node>> &bucket = keyIt->second;
+        bucket.erase(std::remove(bucket.begin(), bucket.end(), pNode), bucket.end());
+
+        if (bucket.empty())
+            mNodeKeyIndex.erase(keyIt);
+    }
+
+    auto idIt = mNodeIDIndex.find(pNode->ID);
+    if (idIt != mNodeIDIndex.end())
+    {
+        std::vector<std::shared_ptr<Node>> &bucket = idIt->second;
+        bucket.erase(std::remove(bucket.begin(), bucket.end(), pNode), bucket.end());
+
+        if (bucket.empty())
+            mNodeIDIndex.erase(idIt);
+    }
+}
+
+void NodeMgr::OnNodeBoundsChanged(Node *pNode)
+{
+    if (pNode->mSpatialProxy == BoundingVolumeTree::cNullProxy || pNode->mSpatialDirty)
+        return;
+
+    pNode->mSpatialDirty = true;
+    mSpatialDirtyNodes.push_back(pNode);
+}
+
+void NodeMgr::AddToSpatialIndex(Node *pNode)
+{
+    TransformStore::Handle handle = pNode->GetTransformHandle();
+    if (handle >= mNodesByHandle.size())
+        mNodesByHandle.resize(handle + 1, nullptr);
+
+    mNodesByHandle[handle] = pNode;
+    pNode->mSpatialProxy = mSpatialIndex.Insert(pNode->GetWorldBounds(), pNode);
+}
+
+void NodeMgr::RemoveFromSpatialIndex(Node *pNode)
+{
+    if (pNode->mSpatialProxy == BoundingVolumeTree::cNullProxy)
+        return;
+
+    mSpatialIndex.Remove(pNode->mSpatialProxy);
+    pNode->mSpatialProxy = BoundingVolumeTree::cNullProxy;
+    mNodesByHandle[pNode->GetTransformHandle()] = nullptr;
+
+    if (pNode->mSpatialDirty)
+    {
+        mSpatialDirtyNodes.erase(std::find(mSpatialDirtyNodes.begin(), mSpatialDirtyNodes.end(), pNode));
+        pNode->mSpatialDirty = false;
+    }
+}
+
+// Only nodes whose world matrix got rebuilt or that were marked by hand are looked at.
+// Most of them stay inside the grown box of their leaf, which leaves the tree as it is.
+void NodeMgr::UpdateSpatialIndex()
+{
+    for (TransformStore::Handle handle : mTransformStore.GetChangedHandles())
+    {
+        if (handle < mNodesByHandle.size() && mNodesByHandle[handle])
+            OnNodeBoundsChanged(mNodesByHandle[handle]);
+    }
+
+    mTransformStore.ClearChangedHandles();
+
+    for (Node *node : mSpatialDirtyNodes)
+    {
+        mSpatialIndex.Update(node->mSpatialProxy, node->GetWorldBounds());
+        node->mSpatialDirty = false;
+    }
+
+    mSpatialDirtyNodes.clear();
+}
+
+void NodeMgr::QueryNodesInFrustum(const Frustum &pFrustum, std::vector<Node *> *pOut) const
+{
+    std::vector<void *> found;
+    mSpatialIndex.QueryFrustum(pFrustum, &found);
+
+    for (void *node : found)
+        pOut->push_back(static_cast<Node *>(node));
+}
+
+void NodeMgr::QueryNodesInRadius(const rio::Vector3f &pCenter, f32 pRadius, std::vector<Node *> *pOut) const
+{
+    std::vector<void *> found;
+    mSpatialIndex.QueryRadius(pCenter, pRadius, &found);
+
+    for (void *node : found)
+        pOut->push_back(static_cast<Node *>(node));
+}
+
+void NodeMgr::QueryNodesOnRay(const rio::Vector3f &pOrigin, const rio::Vector3f &pDirection, f32 pMaxDistance, std::vector<NodeHit> *pOut) const
+{
+    std::vector<BoundingVolumeTree::RayHit> hits;
+    mSpatialIndex.QueryRay(pOrigin, pDirection, pMaxDistance, &hits);
+
+    for (const BoundingVolumeTree::RayHit &hit : hits)
+        pOut->push_back({static_cast<Node *>(hit.userData), hit.distance});
+}
+
+bool NodeMgr::LoadFromFile(std::string fileName, bool pParallel)
 {
-    for (const auto &node : mNodes)
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    std::unique_ptr<SceneLoad> load = OpenScene(fileName);
+    if (!load)
+        return false;
+
+    pParallel = pParallel && JobSystem::instance() && load->nodeCount > cLoadBatchSize;
+
+    if (pParallel)
+    {
+        LoadNodesParallel(load.get());
+    }
+    else
     {
-        if (node.get()->ID == ID)
-            return node.get();
+        while (CreateNextNode(load.get()))
+            ;
     }
 
-    return nullptr;
+    FinishNodes(load.get());
+
+    f32 elapsedMs = std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - start).count();
+    RIO_LOG("[NODEMGR] Loaded %u nodes in %.2f ms%s.\n", load->nodeCount, elapsedMs, pParallel ? " (parallel)" : "");
+
+    return true;
 }
 
-bool NodeMgr::LoadFromFile(std::string fileName)
+bool NodeMgr::LoadFromFileStreaming(std::string fileName)
+{
+    if (mpStreamingLoad)
+    {
+        RIO_LOG("[NODEMGR] Already streaming a scene.\n");
+        return false;
+    }
+
+    mpStreamingLoad = OpenScene(fileName);
+    if (!mpStreamingLoad)
+        return false;
+
+    RIO_LOG("[NODEMGR] Streaming %u nodes, %.2f ms per frame.\n", mpStreamingLoad->nodeCount, mStreamingBudgetMs);
+    return true;
+}
+
+f32 NodeMgr::GetStreamingProgress() const
+{
+    if (!mpStreamingLoad)
+        return 0.f;
+
+    // Creating a node is cheap next to starting its properties, so it only counts for the first tenth.
+    f32 createdShare = mpStreamingLoad->nodeCount ? f32(mpStreamingLoad->createdCount) / f32(mpStreamingLoad->nodeCount) : 1.f;
+    f32 startedShare = mpStreamingLoad->startQueue.empty() ? 0.f : f32(mpStreamingLoad->startedCount) / f32(mpStreamingLoad->startQueue.size());
+
+    return createdShare * 0.1f + startedShare * 0.9f;
+}
+
+std::unique_ptr<NodeMgr::SceneLoad> NodeMgr::OpenScene(const std::string &fileName)
 {
     std::string mapFolderPath = rio::FileDeviceMgr::instance()->getMainFileDevice()->getContentNativePath() + "/map/";
 
     mapFolderPath.append(fileName);
 
-    RIO_LOG("[NODEMGR] Loading YAML from %s\n", mapFolderPath.c_str());
+    std::unique_ptr<SceneLoad> load = std::make_unique<SceneLoad>();
+
+    if (!load->file.Open(mapFolderPath))
+    {
+        RIO_LOG("[NODEMGR] Failed to load %s\n", mapFolderPath.c_str());
+        return nullptr;
+    }
 
-    YAML::Node mapYaml = YAML::LoadFile(mapFolderPath);
     mInstance->currentFilePath = mapFolderPath;
 
-    if (!mapYaml["nodes"])
+    if (SceneFile::IsBinary(load->file.GetData(), load->file.GetSize()))
+    {
+        RIO_LOG("[NODEMGR] Loading binary scene from %s\n", mapFolderPath.c_str());
+        mInstance->mCurrentFileFormat = SCENE_FORMAT_BINARY;
+
+        if (!load->view.Initialize(load->file.GetData(), load->file.GetSize()))
+            return nullptr;
+
+        load->binary = true;
+        load->nodeCount = load->view.GetNodeCount();
+    }
+    else
+    {
+        RIO_LOG("[NODEMGR] Loading YAML from %s\n", mapFolderPath.c_str());
+        mInstance->mCurrentFileFormat = SCENE_FORMAT_YAML;
+
+        YAML::Node mapYaml = YAML::Load(std::string(reinterpret_cast<const char *>(load->file.GetData()), load->file.GetSize()));
+
+        if (!mapYaml["nodes"])
+            return nullptr;
+
+        load->binary = false;
+        load->nodesYaml = mapYaml["nodes"];
+        load->nextYamlNode = load->nodesYaml.begin();
+        load->nodeCount = load->nodesYaml.size();
+        load->nodeYamls.resize(load->nodeCount);
+    }
+
+    load->fileIDs.resize(load->nodeCount);
+    load->parentIDs.resize(load->nodeCount);
+    load->hasParent.resize(load->nodeCount, false);
+
+    return load;
+}
+
+bool NodeMgr::CreateNextNode(SceneLoad *pLoad)
+{
+    if (pLoad->createdCount >= pLoad->nodeCount)
         return false;
 
-    YAML::Node nodes = mapYaml["nodes"];
+    u32 index = pLoad->createdCount;
+
+    std::shared_ptr<Node> addedNode = CreateNodeShell(pLoad, index);
+    ReadNode(pLoad, index, addedNode);
+    AddLoadedNode(pLoad, index, addedNode);
+
+    pLoad->createdNodes.push_back(addedNode);
+    pLoad->createdCount++;
+
+    return true;
+}
+
+// Node objects are created on this thread in file order, the transform store isn't thread safe
+// and node IDs follow the order nodes are created in. Transforms and properties are read in parallel after that.
+void NodeMgr::LoadNodesParallel(SceneLoad *pLoad)
+{
+    u32 nodeCount = pLoad->nodeCount;
+
+    std::vector<std::shared_ptr<Node>> nodes(nodeCount);
+
+    for (u32 i = 0; i < nodeCount; i++)
+        nodes[i] = CreateNodeShell(pLoad, i);
 
-    for (YAML::const_iterator it = nodes.begin(); it != nodes.end(); ++it)
+    pLoad->parallel = true;
+
+    JobSystem::instance()->ParallelFor(nodeCount, cLoadBatchSize, [this, pLoad, &nodes](u32 pBegin, u32 pEnd)
+                                       {
+                                           for (u32 i = pBegin; i < pEnd; i++)
+                                               ReadNode(pLoad, i, nodes[i]);
+                                       });
+
+    // Only adding the nodes to the scene is serialized, in file order like a sequential load.
+    for (u32 i = 0; i < nodeCount; i++)
+        AddLoadedNode(pLoad, i, nodes[i]);
+
+    pLoad->createdCount = nodeCount;
+}
+
+// Has to be called in file order, YAML nodes are walked with one iterator.
+std::shared_ptr<Node> NodeMgr::CreateNodeShell(SceneLoad *pLoad, u32 pIndex)
+{
+    std::string nodeName;
+
+    if (pLoad->binary)
     {
-        int id = it->first.as<int>();
+        const SceneFile::NodeRecord &node = pLoad->view.GetNode(pIndex);
+
+        pLoad->fileIDs[pIndex] = node.id;
+        nodeName = pLoad->view.GetString(node.nameOffset);
+    }
+    else
+    {
+        YAML::const_iterator it = pLoad->nextYamlNode++;
+
+        pLoad->fileIDs[pIndex] = it->first.as<int>();
+        pLoad->nodeYamls[pIndex] = it->second;
+        nodeName = it->second["name"].as<std::string>();
+    }
 
-        YAML::Node node = it->second;
+    // The transform is set by ReadNode().
+    return std::make_shared<Node>(nodeName, rio::Vector3f{0, 0, 0}, rio::Vector3f{0, 0, 0}, rio::Vector3f{1, 1, 1});
+}
 
-        std::string nodeName = node["name"].as<std::string>();
+// Only touches pNode and the slots of pIndex in pLoad, so different nodes can be read at the same time.
+void NodeMgr::ReadNode(SceneLoad *pLoad, u32 pIndex, const std::shared_ptr<Node> &pNode)
+{
+    if (pLoad->binary)
+    {
+        // Transforms and names are read straight from the records, only property bodies still go through yaml-cpp.
+        const SceneFile::NodeRecord &node = pLoad->view.GetNode(pIndex);
 
-        rio::Vector3f nodePosition, nodeRotation, nodeScale;
-        nodePosition = {node["transform"]["position"]["x"].as<f32>(), node["transform"]["position"]["y"].as<f32>(), node["transform"]["position"]["z"].as<f32>()};
-        nodeRotation = {node["transform"]["rotation"]["x"].as<f32>(), node["transform"]["rotation"]["y"].as<f32>(), node["transform"]["rotation"]["z"].as<f32>()};
-        nodeScale = {node["transform"]["scale"]["x"].as<f32>(), node["transform"]["scale"]["y"].as<f32>(), node["transform"]["scale"]["z"].as<f32>()};
+        pNode->SetPosition({node.position[0], node.position[1], node.position[2]});
+        pNode->SetRotation({node.rotation[0], node.rotation[1], node.rotation[2]});
+        pNode->SetScale({node.scale[0], node.scale[1], node.scale[2]});
 
-        auto addedNode = std::make_shared<Node>(nodeName, nodePosition, nodeRotation, nodeScale);
-        NodeMgr::instance()->AddNode(addedNode);
+        pLoad->hasParent[pIndex] = (node.flags & SceneFile::NODE_FLAG_HAS_PARENT) != 0;
+        pLoad->parentIDs[pIndex] = node.parentId;
 
-        for (YAML::const_iterator pt = node["properties"].begin(); pt != node["properties"].end(); ++pt)
+        for (u32 j = 0; j < node.propertyCount; j++)
         {
-            std::string propertyName = pt->first.as<std::string>();
-            YAML::Node propertyNode = pt->second;
+            const SceneFile::PropertyRecord &property = pLoad->view.GetProperty(node.firstProperty + j);
+            CreateProperty(pNode, pLoad->view.GetString(property.nameOffset), YAML::Load(pLoad->view.GetBlob(property)));
+        }
+
+        return;
+    }
+
+    // yaml-cpp adds nodes to the memory shared by the whole document when a missing key is looked up,
+    // so parallel reads work on a private copy of the node.
+    YAML::Node node = pLoad->parallel ? YAML::Clone(pLoad->nodeYamls[pIndex]) : pLoad->nodeYamls[pIndex];
+
+    pNode->SetPosition({node["transform"]["position"]["x"].as<f32>(), node["transform"]["position"]["y"].as<f32>(), node["transform"]["position"]["z"].as<f32>()});
+    pNode->SetRotation({node["transform"]["rotation"]["x"].as<f32>(), node["transform"]["rotation"]["y"].as<f32>(), node["transform"]["rotation"]["z"].as<f32>()});
+    pNode->SetScale({node["transform"]["scale"]["x"].as<f32>(), node["transform"]["scale"]["y"].as<f32>(), node["transform"]["scale"]["z"].as<f32>()});
+
+    if (node["parent"])
+    {
+        pLoad->hasParent[pIndex] = true;
+        pLoad->parentIDs[pIndex] = node["parent"].as<int>();
+    }
 
-            RIO_LOG("[NODEMGR] Loading Property: %s..\n", propertyName.c_str());
+    for (YAML::const_iterator pt = node["properties"].begin(); pt != node["properties"].end(); ++pt)
+        CreateProperty(pNode, pt->first.as<std::string>(), pt->second);
+
+    // Drops the reference into the document.
+    pLoad->nodeYamls[pIndex].reset();
+}
+
+void NodeMgr::AddLoadedNode(SceneLoad *pLoad, u32 pIndex, const std::shared_ptr<Node> &pNode)
+{
+    NodeMgr::instance()->AddNode(pNode);
+
+    pLoad->loadedNodes[pLoad->fileIDs[pIndex]] = pNode;
+
+    if (pLoad->hasParent[pIndex])
+        pLoad->pendingParents.emplace_back(pNode, pLoad->parentIDs[pIndex]);
+}
+
+void NodeMgr::CreateProperty(const std::shared_ptr<Node> &pNode, const std::string &pPropertyName, const YAML::Node &pPropertyNode)
+{
+    RIO_LOG("[NODEMGR] Loading Property: %s..\n", pPropertyName.c_str());
+
+    auto fp = mPropertyFactory.find(pPropertyName);
+    if (fp != mPropertyFactory.end())
+    {
+        auto property = fp->second(pNode);
+        property->Load(pPropertyNode);
+        pNode->AddProperty(std::move(property));
 
-            auto fp = mPropertyFactory.find(propertyName);
-            if (fp != mPropertyFactory.end())
+        RIO_LOG("[NODEMGR] Added Property: %s\n", pPropertyName.c_str());
+    }
+    else
+    {
+        RIO_LOG("[NODEMGR] Unknown Property: %s\n", pPropertyName.c_str());
+    }
+}
+
+// Parents can be listed after their children, so links are resolved once every node exists.
+void NodeMgr::FinishNodes(SceneLoad *pLoad)
+{
+    for (auto &pendingParent : pLoad->pendingParents)
+    {
+        auto parentIt = pLoad->loadedNodes.find(pendingParent.second);
+
+        if (parentIt == pLoad->loadedNodes.end() || !pendingParent.first->SetParent(parentIt->second))
+            RIO_LOG("[NODEMGR] Invalid parent %d for %s\n", pendingParent.second, pendingParent.first->nodeKey.c_str());
+    }
+
+    pLoad->loadedNodes.clear();
+    pLoad->pendingParents.clear();
+}
+
+// Nodes are created first, then their properties are started, cameras ahead of everything else
+// since other properties look the main camera up in Start(). Every step runs at least once per frame.
+void NodeMgr::UpdateStreaming()
+{
+    SceneLoad *load = mpStreamingLoad.get();
+    if (!load)
+        return;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    bool didWork = false;
+
+    load->frameCount++;
+
+    auto hasBudget = [this, start, &didWork]()
+    {
+        f32 elapsedMs = std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return !didWork || elapsedMs < mStreamingBudgetMs;
+    };
+
+    while (load->createdCount < load->nodeCount && hasBudget())
+    {
+        CreateNextNode(load);
+        didWork = true;
+    }
+
+    if (load->createdCount < load->nodeCount)
+        return;
+
+    if (!load->nodesFinished)
+    {
+        FinishNodes(load);
+
+        for (int pass = 0; pass < 2; pass++)
+        {
+            for (const std::weak_ptr<Node> &createdNode : load->createdNodes)
             {
-                auto property = fp->second(addedNode);
-                property->Load(propertyNode);
-                addedNode->AddProperty(std::move(property));
+                std::shared_ptr<Node> node = createdNode.lock();
+                if (!node)
+                    continue;
 
-                RIO_LOG("[NODEMGR] Added Property: %s\n", propertyName.c_str());
+                for (auto &property : node->properties)
+                {
+                    if ((property->GetPropertyType() == PROPERTY_TYPE_CAMERA) == (pass == 0))
+                        load->startQueue.push_back({createdNode, property.get()});
+                }
             }
-            else
+        }
+
+        load->nodesFinished = true;
+    }
+
+    while (load->startedCount < load->startQueue.size() && hasBudget())
+    {
+        u32 begin = load->startedCount;
+        u32 end = std::min<u32>(load->startQueue.size(), begin + cStreamingStartBatchSize);
+
+        // Nodes deleted in the meantime took their properties with them.
+        auto startRange = [load, begin](u32 pBegin, u32 pEnd)
+        {
+            for (u32 i = begin + pBegin; i < begin + pEnd; i++)
             {
-                RIO_LOG("[NODEMGR] Unknown Property: %s\n", propertyName.c_str());
+                if (!load->startQueue[i].node.expired())
+                    load->startQueue[i].property->StartAsync();
             }
+        };
+
+        if (JobSystem::instance())
+            JobSystem::instance()->ParallelFor(end - begin, 1, startRange);
+        else
+            startRange(0, end - begin);
+
+        rio::PrimitiveRenderer::instance()->begin();
+
+        for (u32 i = begin; i < end; i++)
+        {
+            std::shared_ptr<Node> node = load->startQueue[i].node.lock();
+            if (!node)
+                continue;
+
+            load->startQueue[i].property->Start();
+            node->MarkBoundsDirty();
         }
+
+        rio::PrimitiveRenderer::instance()->end();
+
+        load->startedCount = end;
+        didWork = true;
     }
 
-    return true;
+    if (load->startedCount < load->startQueue.size())
+        return;
+
+    f32 elapsedMs = std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - load->startTime).count();
+    RIO_LOG("[NODEMGR] Streamed %u nodes over %u frames in %.2f ms.\n", load->nodeCount, load->frameCount, elapsedMs);
+
+    mpStreamingLoad.reset();
 }
 
-bool NodeMgr::SaveToFile()
+std::string NodeMgr::GetSavePath(SceneFormat pFormat) const
 {
-    YAML::Emitter outYaml;
-
-    outYaml << YAML::BeginMap;
-    outYaml << YAML::Key << "nodes" << YAML::BeginMap;
+    std::string filePath = currentFilePath;
 
-    for (auto &node : mInstance->mNodes)
+    if (pFormat != mCurrentFileFormat)
     {
-        outYaml << YAML::Key << node->ID << YAML::BeginMap;
-        outYaml << YAML::Key << "name" << YAML::Value << node->nodeKey;
+        size_t extension = filePath.find_last_of('.');
+        size_t folder = filePath.find_last_of('/');
+        if (extension != std::string::npos && (folder == std::string::npos || folder < extension))
+            filePath.erase(extension);
 
-        outYaml << YAML::Key << "transform" << YAML::BeginMap;
+        filePath.append(pFormat == SCENE_FORMAT_BINARY ? SceneFile::cExtension : ".yaml");
+    }
 
-        outYaml << YAML::Key << "position" << YAML::BeginMap;
-        outYaml << YAML::Key << "x" << YAML::Value << node->GetPosition().x;
-        outYaml << YAML::Key << "y" << YAML::Value << node->GetPosition().y;
-        outYaml << YAML::Key << "z" << YAML::Value << node->GetPosition().z << YAML::EndMap;
+    return filePath;
+}
+
+void NodeMgr::TakeSnapshot(SaveSnapshot *pSnapshot, SceneFormat pFormat)
+{
+    pSnapshot->format = pFormat;
+    pSnapshot->filePath = GetSavePath(pFormat);
+    pSnapshot->nodes.resize(mNodes.size());
 
-        outYaml << YAML::Key << "rotation" << YAML::BeginMap;
-        outYaml << YAML::Key << "x" << YAML::Value << node->GetRotation().x;
-        outYaml << YAML::Key << "y" << YAML::Value << node->GetRotation().y;
-        outYaml << YAML::Key << "z" << YAML::Value << node->GetRotation().z << YAML::EndMap;
+    for (u32 i = 0; i < mNodes.size(); i++)
+    {
+        const std::shared_ptr<Node> &node = mNodes[i];
+        SaveSnapshot::NodeEntry &entry = pSnapshot->nodes[i];
+
+        std::shared_ptr<Node> parentNode = node->GetParent();
 
-        outYaml << YAML::Key << "scale" << YAML::BeginMap;
-        outYaml << YAML::Key << "x" << YAML::Value << node->GetScale().x;
-        outYaml << YAML::Key << "y" << YAML::Value << node->GetScale().y;
-        outYaml << YAML::Key << "z" << YAML::Value << node->GetScale().z << YAML::EndMap << YAML::EndMap;
+        entry.node = node;
+        entry.id = node->ID;
+        entry.name = node->nodeKey;
+        entry.hasParent = parentNode != nullptr;
+        entry.parentId = parentNode ? parentNode->ID : 0;
+        entry.position = node->GetPosition();
+        entry.rotation = node->GetRotation();
+        entry.scale = node->GetScale();
+        entry.serialize = pFormat == SCENE_FORMAT_BINARY || node->IsSaveDirty() || node->mSaveParentID != entry.parentId;
 
-        outYaml << YAML::Key << "properties" << YAML::BeginMap;
+        if (!entry.serialize)
+        {
+            entry.fragment = node->mSaveFragment;
+            continue;
+        }
 
         for (auto &property : node->properties)
+            entry.properties.push_back(property->Save());
+
+        pSnapshot->serializedCount++;
+
+        // Changes from here on belong to the next save. FinishSnapshot() marks the node again if this one fails.
+        if (pFormat == SCENE_FORMAT_YAML)
+        {
+            node->mSaveDirty = false;
+            for (auto &property : node->properties)
+                property->ClearDirty();
+        }
+    }
+}
+
+void NodeMgr::EmitNodeYaml(YAML::Emitter &pOut, const SaveSnapshot::NodeEntry &pEntry)
+{
+    pOut << YAML::BeginMap;
+    pOut << YAML::Key << pEntry.id << YAML::BeginMap;
+    pOut << YAML::Key << "name" << YAML::Value << pEntry.name;
+
+    if (pEntry.hasParent)
+        pOut << YAML::Key << "parent" << YAML::Value << pEntry.parentId;
+
+    SceneFile::EmitYamlTransform(pOut, pEntry.position, pEntry.rotation, pEntry.scale);
+
+    pOut << YAML::Key << "properties" << YAML::BeginMap;
+
+    for (const YAML::Node &propertyNode : pEntry.properties)
+        pOut << YAML::Key << propertyNode.begin()->first << YAML::Value << propertyNode.begin()->second;
+
+    pOut << YAML::EndMap << YAML::EndMap << YAML::EndMap;
+}
+
+// Touches nothing but the snapshot, so it can run on the save thread.
+void NodeMgr::WriteSnapshot(SaveSnapshot *pSnapshot)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    if (pSnapshot->format == SCENE_FORMAT_BINARY)
+    {
+        SceneFile::Builder builder;
+
+        for (SaveSnapshot::NodeEntry &entry : pSnapshot->nodes)
         {
-            YAML::Node propertyNode = property->Save();
-            outYaml << YAML::Key << propertyNode.begin()->first << YAML::Value << propertyNode.begin()->second;
+            builder.AddNode(entry.id, entry.name, entry.hasParent, entry.parentId, entry.position, entry.rotation, entry.scale);
+
+            for (const YAML::Node &propertyNode : entry.properties)
+            {
+                YAML::Emitter propertyYaml;
+                propertyYaml << propertyNode.begin()->second;
+
+                builder.AddProperty(propertyNode.begin()->first.as<std::string>(), propertyYaml.c_str());
+            }
+
+            pSnapshot->writtenCount++;
         }
 
-        outYaml << YAML::EndMap << YAML::EndMap;
+        std::vector<u8> outBinary;
+        builder.Build(&outBinary);
+
+        pSnapshot->result = SceneFile::WriteFile(pSnapshot->filePath, outBinary.data(), outBinary.size());
     }
+    else
+    {
+        const std::string indent(cYamlIndent, ' ');
+        std::string outYaml = pSnapshot->nodes.empty() ? "nodes: {}\n" : "nodes:\n";
 
-    RIO_LOG("%s\n", mInstance->currentFilePath.c_str());
+        for (SaveSnapshot::NodeEntry &entry : pSnapshot->nodes)
+        {
+            if (entry.serialize)
+            {
+                YAML::Emitter nodeYaml;
+                nodeYaml.SetIndent(cYamlIndent);
+                EmitNodeYaml(nodeYaml, entry);
 
-    rio::FileDevice *fileDevice = rio::FileDeviceMgr::instance()->getNativeFileDevice();
-    rio::FileHandle fileHandle;
-    fileDevice->open(&fileHandle, mInstance->currentFilePath, rio::FileDevice::FILE_OPEN_FLAG_WRITE);
-    fileDevice->write(&fileHandle, (u8 *)(outYaml.c_str()), strlen(outYaml.c_str()));
-    fileDevice->close(&fileHandle);
+                // Every line moves one level in, under "nodes".
+                const char *line = nodeYaml.c_str();
+                while (*line != '\0')
+                {
+                    const char *lineEnd = std::strchr(line, '\n');
+                    size_t lineLength = lineEnd ? size_t(lineEnd - line) : std::strlen(line);
 
-    return true;
+                    entry.fragment.append(indent).append(line, lineLength).push_back('\n');
+                    line += lineLength + (lineEnd ? 1 : 0);
+                }
+            }
+
+            outYaml.append(entry.fragment);
+            pSnapshot->writtenCount++;
+        }
+
+        pSnapshot->result = SceneFile::WriteFile(pSnapshot->filePath, outYaml.data(), outYaml.size());
+    }
+
+    pSnapshot->timeMs = std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void NodeMgr::FinishSnapshot(SaveSnapshot *pSnapshot)
+{
+    if (pSnapshot->format == SCENE_FORMAT_YAML)
+    {
+        for (SaveSnapshot::NodeEntry &entry : pSnapshot->nodes)
+        {
+            std::shared_ptr<Node> node = entry.node.lock();
+            if (!entry.serialize || !node)
+                continue;
+
+            if (pSnapshot->result)
+            {
+                node->mSaveFragment = std::move(entry.fragment);
+                node->mSaveParentID = entry.parentId;
+            }
+            else
+                node->MarkSaveDirty();
+        }
+    }
+
+    mSaveCount++;
+    mLastSaveResult = pSnapshot->result;
+    mLastSaveTimeMs = pSnapshot->timeMs;
+
+    RIO_LOG("[NODEMGR] %s %s: %zu nodes, %u serialized, %.2f ms.\n", pSnapshot->result ? "Saved" : "Failed to save", pSnapshot->filePath.c_str(),
+            pSnapshot->nodes.size(), pSnapshot->serializedCount, pSnapshot->timeMs);
+}
+
+bool NodeMgr::SaveToFile()
+{
+    return SaveToFile(mInstance->mCurrentFileFormat);
+}
+
+bool NodeMgr::SaveToFile(SceneFormat pFormat)
+{
+    if (mInstance->mpStreamingLoad)
+    {
+        RIO_LOG("[NODEMGR] Can't save while the scene is still streaming in.\n");
+        return false;
+    }
+
+    WaitForSave();
+
+    SaveSnapshot snapshot;
+    TakeSnapshot(&snapshot, pFormat);
+    WriteSnapshot(&snapshot);
+    FinishSnapshot(&snapshot);
+
+    return snapshot.result;
+}
+
+void NodeMgr::SaveToFileAsync()
+{
+    SaveToFileAsync(mCurrentFileFormat);
+}
+
+void NodeMgr::SaveToFileAsync(SceneFormat pFormat)
+{
+    mSaveRequested = true;
+    mRequestedSaveFormat = pFormat;
+}
+
+f32 NodeMgr::GetSaveProgress() const
+{
+    if (!mpSaveSnapshot || mpSaveSnapshot->nodes.empty())
+        return 0.f;
+
+    return f32(mpSaveSnapshot->writtenCount) / f32(mpSaveSnapshot->nodes.size());
+}
+
+void NodeMgr::UpdateSave()
+{
+    if (mpSaveSnapshot && mSaveThreadDone)
+        WaitForSave();
+
+    // A snapshot now would miss the nodes still to come.
+    if (mpSaveSnapshot || !mSaveRequested || mpStreamingLoad)
+        return;
+
+    mSaveRequested = false;
+
+    mpSaveSnapshot = std::make_unique<SaveSnapshot>();
+    TakeSnapshot(mpSaveSnapshot.get(), mRequestedSaveFormat);
+
+    SaveSnapshot *snapshot = mpSaveSnapshot.get();
+    auto writeSnapshot = [this, snapshot]()
+    {
+        WriteSnapshot(snapshot);
+        mSaveThreadDone = true;
+    };
+
+    mSaveThreadDone = false;
+    mSaveThread = std::thread(writeSnapshot);
+}
+
+void NodeMgr::WaitForSave()
+{
+    if (!mpSaveSnapshot)
+        return;
+
+    mSaveThread.join();
+
+    FinishSnapshot(mpSaveSnapshot.get());
+    mpSaveSnapshot.reset();
 }
 
 void NodeMgr::Start()
 {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // File reads and decoding for every property first, spread over the job system.
+    for (PropertyType type : cAsyncStartPhase)
+    {
+        const std::vector<Property *> &typed = mPropertiesByType[type];
+
+        auto startRange = [&typed](u32 pBegin, u32 pEnd)
+        {
+            for (u32 i = pBegin; i < pEnd; i++)
+                typed[i]->StartAsync();
+        };
+
+        if (JobSystem::instance())
+            JobSystem::instance()->ParallelFor(typed.size(), 1, startRange);
+        else
+            startRange(0, typed.size());
+    }
+
+    // Then everything that needs the GL context, on this thread.
     rio::PrimitiveRenderer::instance()->begin();
 
     for (auto &node : mNodes)
@@ -219,20 +981,106 @@ void NodeMgr::Start()
         {
             property->Start();
         }
+
+        node->MarkBoundsDirty();
     }
 
     rio::PrimitiveRenderer::instance()->end();
+
+    f32 elapsedMs = std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - start).count();
+    RIO_LOG("[NODEMGR] Started %zu nodes in %.2f ms.\n", mNodes.size(), elapsedMs);
 }
 
 void NodeMgr::Update()
 {
-    for (auto &node : mNodes)
+    // Frame boundary, nothing has touched the scene yet this frame.
+    UpdateSave();
+    UpdateStreaming();
+
+    EditorMgr::instance()->BindRenderBuffer();
+
+    for (PropertyType type : cCameraPhase)
+        UpdateProperties(type);
+
+    // Rebuild every world matrix that changed since last frame in one pass before properties consume them.
+    // Done after the cameras so nodes that follow a camera are not a frame behind.
+    mTransformStore.UpdateWorldMatrices();
+
+    // View and light blocks go up once here, every draw below only binds them. Also starts this frame's part of the draw ring.
+    FrameUniformMgr::instance()->Update();
+
+    UpdatePropertiesAsync();
+    FrameUniformMgr::instance()->FinishWrites();
+
+    // Mesh and Mii head bounds follow their world matrices in UpdateAsync(), so the index catches up only now.
+    UpdateSpatialIndex();
+
+    for (PropertyType type : cLogicPhase)
+        UpdateProperties(type);
+
+    for (PropertyType type : cOpaquePhase)
+        UpdateProperties(type);
+
+    for (PropertyType type : cTranslucentPhase)
     {
-        for (auto &property : node->properties)
+        for (Property *property : mPropertiesByType[type])
         {
-            EditorMgr::instance()->BindRenderBuffer();
-            property->Update();
-            EditorMgr::instance()->UnbindRenderBuffer();
+            if (property->mInitialized)
+                property->DrawXlu();
+        }
+    }
+
+    FrameUniformMgr::instance()->EndFrame();
+
+    EditorMgr::instance()->UnbindRenderBuffer();
+}
+
+void NodeMgr::UpdatePropertiesAsync()
+{
+    JobSystem *jobSystem = JobSystem::instance();
+    JobSystem::JobCounter counter{0};
+
+    for (PropertyType type : cAsyncPhase)
+    {
+        const std::vector<Property *> &typed = mPropertiesByType[type];
+
+        if (!jobSystem)
+        {
+            for (Property *property : typed)
+            {
+                if (property->mInitialized)
+                    property->UpdateAsync();
+            }
+
+            continue;
         }
+
+        for (u32 begin = 0; begin < typed.size(); begin += cAsyncBatchSize)
+        {
+            u32 end = std::min<u32>(typed.size(), begin + cAsyncBatchSize);
+
+            jobSystem->Submit([&typed, begin, end]
+                              {
+                                  for (u32 i = begin; i < end; i++)
+                                  {
+                                      if (typed[i]->mInitialized)
+                                          typed[i]->UpdateAsync();
+                                  }
+                              },
+                              &counter);
+        }
+    }
+
+    if (jobSystem)
+        jobSystem->Wait(counter);
+}
+
+void NodeMgr::UpdateProperties(PropertyType pType)
+{
+    // Properties a streaming load has not started yet, or that failed to start, are skipped.
+    for (Property *property : mPropertiesByType[pType])
+    {
+        if (property->mInitialized)
+            property->Update();
     }
 }
\ No newline at end of file
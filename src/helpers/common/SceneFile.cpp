@@ -0,0 +1,338 @@
+#include <helpers/common/SceneFile.h>
+#include <helpers/common/MappedFile.h>
+
+#include <cstring>
+#include <fstream>
+
+#if RIO_IS_WIN
+#include <filesystem>
+#endif // RIO_IS_WIN
+
+const char SceneFile::cMagic[4] = {'R', 'S', 'C', 'N'};
+const char SceneFile::cExtension[] = ".bmap";
+
+namespace
+{
+    inline void CopyVector(f32 *pDst, const rio::Vector3f &pSrc)
+    {
+        pDst[0] = pSrc.x;
+        pDst[1] = pSrc.y;
+        pDst[2] = pSrc.z;
+    }
+
+    inline rio::Vector3f ReadVector(const YAML::Node &pNode)
+    {
+        return {pNode["x"].as<f32>(), pNode["y"].as<f32>(), pNode["z"].as<f32>()};
+    }
+
+    inline bool IsInside(u32 pOffset, u64 pSize, size_t pDataSize)
+    {
+        return pOffset <= pDataSize && pSize <= pDataSize - pOffset;
+    }
+}
+
+bool SceneFile::View::Initialize(const u8 *pData, size_t pSize)
+{
+    if (!IsBinary(pData, pSize))
+        return false;
+
+    const Header *header = reinterpret_cast<const Header *>(pData);
+
+    if (header->version != cVersion || header->fileSize > pSize)
+    {
+        RIO_LOG("[SCENEFILE] Unsupported or truncated scene file.\n");
+        return false;
+    }
+
+    if (!IsInside(header->nodeOffset, u64(header->nodeCount) * sizeof(NodeRecord), pSize) ||
+        !IsInside(header->propertyOffset, u64(header->propertyCount) * sizeof(PropertyRecord), pSize) ||
+        !IsInside(header->stringTableOffset, header->stringTableSize, pSize) ||
+        !IsInside(header->blobOffset, header->blobSize, pSize))
+    {
+        RIO_LOG("[SCENEFILE] Scene file sections out of range.\n");
+        return false;
+    }
+
+    mpHeader = header;
+    mpNodes = reinterpret_cast<const NodeRecord *>(pData + header->nodeOffset);
+    mpProperties = reinterpret_cast<const PropertyRecord *>(pData + header->propertyOffset);
+    mpStrings = reinterpret_cast<const char *>(pData + header->stringTableOffset);
+    mpBlobs = reinterpret_cast<const char *>(pData + header->blobOffset);
+
+    // Offsets inside records are checked once here, so the loader can use them as they are.
+    for (u32 i = 0; i < header->nodeCount; i++)
+    {
+        const NodeRecord &node = mpNodes[i];
+        if (node.nameOffset >= header->stringTableSize || !IsInside(node.firstProperty, node.propertyCount, header->propertyCount))
+        {
+            RIO_LOG("[SCENEFILE] Invalid node record %u.\n", i);
+            return false;
+        }
+    }
+
+    for (u32 i = 0; i < header->propertyCount; i++)
+    {
+        const PropertyRecord &property = mpProperties[i];
+        if (property.nameOffset >= header->stringTableSize || !IsInside(property.blobOffset, u64(property.blobSize) + 1, header->blobSize))
+        {
+            RIO_LOG("[SCENEFILE] Invalid property record %u.\n", i);
+            return false;
+        }
+    }
+
+    if ((header->stringTableSize != 0 && mpStrings[header->stringTableSize - 1] != '\0') ||
+        (header->blobSize != 0 && mpBlobs[header->blobSize - 1] != '\0'))
+    {
+        RIO_LOG("[SCENEFILE] Unterminated string table.\n");
+        return false;
+    }
+
+    return true;
+}
+
+u32 SceneFile::Builder::AddString(const std::string &pString)
+{
+    auto it = mStringOffsets.find(pString);
+    if (it != mStringOffsets.end())
+        return it->second;
+
+    u32 offset = mStrings.size();
+    mStrings.append(pString);
+    mStrings.push_back('\0');
+
+    mStringOffsets.emplace(pString, offset);
+    return offset;
+}
+
+void SceneFile::Builder::AddNode(s32 pID, const std::string &pName, bool pHasParent, s32 pParentID, const rio::Vector3f &pPosition, const rio::Vector3f &pRotation, const rio::Vector3f &pScale)
+{
+    NodeRecord record;
+    record.id = pID;
+    record.parentId = pHasParent ? pParentID : 0;
+    record.flags = pHasParent ? NODE_FLAG_HAS_PARENT : 0;
+    record.nameOffset = AddString(pName);
+    CopyVector(record.position, pPosition);
+    CopyVector(record.rotation, pRotation);
+    CopyVector(record.scale, pScale);
+    record.firstProperty = mProperties.size();
+    record.propertyCount = 0;
+
+    mNodes.push_back(record);
+}
+
+void SceneFile::Builder::AddProperty(const std::string &pName, const std::string &pData)
+{
+    RIO_ASSERT(!mNodes.empty());
+
+    PropertyRecord record;
+    record.nameOffset = AddString(pName);
+    record.blobOffset = mBlobs.size();
+    record.blobSize = pData.size();
+
+    mBlobs.append(pData);
+    mBlobs.push_back('\0');
+
+    mProperties.push_back(record);
+    mNodes.back().propertyCount++;
+}
+
+void SceneFile::Builder::Build(std::vector<u8> *pOut) const
+{
+    Header header;
+    std::memcpy(header.magic, cMagic, sizeof(cMagic));
+    header.byteOrder = cByteOrderMark;
+    header.version = cVersion;
+    header.nodeCount = mNodes.size();
+    header.nodeOffset = sizeof(Header);
+    header.propertyCount = mProperties.size();
+    header.propertyOffset = header.nodeOffset + mNodes.size() * sizeof(NodeRecord);
+    header.stringTableOffset = header.propertyOffset + mProperties.size() * sizeof(PropertyRecord);
+    header.stringTableSize = mStrings.size();
+    header.blobOffset = header.stringTableOffset + mStrings.size();
+    header.blobSize = mBlobs.size();
+    header.fileSize = header.blobOffset + mBlobs.size();
+
+    pOut->resize(header.fileSize);
+    u8 *data = pOut->data();
+
+    std::memcpy(data, &header, sizeof(Header));
+    if (!mNodes.empty())
+        std::memcpy(data + header.nodeOffset, mNodes.data(), mNodes.size() * sizeof(NodeRecord));
+    if (!mProperties.empty())
+        std::memcpy(data + header.propertyOffset, mProperties.data(), mProperties.size() * sizeof(PropertyRecord));
+    std::memcpy(data + header.stringTableOffset, mStrings.data(), mStrings.size());
+    std::memcpy(data + header.blobOffset, mBlobs.data(), mBlobs.size());
+}
+
+bool SceneFile::IsBinary(const u8 *pData, size_t pSize)
+{
+    if (pData == nullptr || pSize < sizeof(Header))
+        return false;
+
+    const Header *header = reinterpret_cast<const Header *>(pData);
+    if (std::memcmp(header->magic, cMagic, sizeof(cMagic)) != 0)
+        return false;
+
+    // Written on the other endianness, would need swapping.
+    if (header->byteOrder != cByteOrderMark)
+    {
+        RIO_LOG("[SCENEFILE] Scene file has the wrong byte order.\n");
+        return false;
+    }
+
+    return true;
+}
+
+void SceneFile::EmitYamlTransform(YAML::Emitter &pOut, const rio::Vector3f &pPosition, const rio::Vector3f &pRotation, const rio::Vector3f &pScale)
+{
+    pOut << YAML::Key << "transform" << YAML::BeginMap;
+
+    pOut << YAML::Key << "position" << YAML::BeginMap;
+    pOut << YAML::Key << "x" << YAML::Value << pPosition.x;
+    pOut << YAML::Key << "y" << YAML::Value << pPosition.y;
+    pOut << YAML::Key << "z" << YAML::Value << pPosition.z << YAML::EndMap;
+
+    pOut << YAML::Key << "rotation" << YAML::BeginMap;
+    pOut << YAML::Key << "x" << YAML::Value << pRotation.x;
+    pOut << YAML::Key << "y" << YAML::Value << pRotation.y;
+    pOut << YAML::Key << "z" << YAML::Value << pRotation.z << YAML::EndMap;
+
+    pOut << YAML::Key << "scale" << YAML::BeginMap;
+    pOut << YAML::Key << "x" << YAML::Value << pScale.x;
+    pOut << YAML::Key << "y" << YAML::Value << pScale.y;
+    pOut << YAML::Key << "z" << YAML::Value << pScale.z << YAML::EndMap << YAML::EndMap;
+}
+
+bool SceneFile::ConvertYamlToBinary(const YAML::Node &pYaml, std::vector<u8> *pOut)
+{
+    if (!pYaml["nodes"])
+        return false;
+
+    Builder builder;
+
+    for (YAML::const_iterator it = pYaml["nodes"].begin(); it != pYaml["nodes"].end(); ++it)
+    {
+        const YAML::Node &node = it->second;
+        const YAML::Node &transform = node["transform"];
+
+        builder.AddNode(it->first.as<s32>(), node["name"].as<std::string>(), bool(node["parent"]), node["parent"] ? node["parent"].as<s32>() : 0,
+                        ReadVector(transform["position"]), ReadVector(transform["rotation"]), ReadVector(transform["scale"]));
+
+        for (YAML::const_iterator pt = node["properties"].begin(); pt != node["properties"].end(); ++pt)
+        {
+            YAML::Emitter propertyYaml;
+            propertyYaml << pt->second;
+
+            builder.AddProperty(pt->first.as<std::string>(), propertyYaml.c_str());
+        }
+    }
+
+    builder.Build(pOut);
+    return true;
+}
+
+void SceneFile::ConvertBinaryToYaml(const View &pView, YAML::Emitter &pOut)
+{
+    pOut << YAML::BeginMap;
+    pOut << YAML::Key << "nodes" << YAML::BeginMap;
+
+    for (u32 i = 0; i < pView.GetNodeCount(); i++)
+    {
+        const NodeRecord &node = pView.GetNode(i);
+
+        pOut << YAML::Key << node.id << YAML::BeginMap;
+        pOut << YAML::Key << "name" << YAML::Value << pView.GetString(node.nameOffset);
+
+        if (node.flags & NODE_FLAG_HAS_PARENT)
+            pOut << YAML::Key << "parent" << YAML::Value << node.parentId;
+
+        EmitYamlTransform(pOut, {node.position[0], node.position[1], node.position[2]},
+                          {node.rotation[0], node.rotation[1], node.rotation[2]},
+                          {node.scale[0], node.scale[1], node.scale[2]});
+
+        pOut << YAML::Key << "properties" << YAML::BeginMap;
+
+        for (u32 j = 0; j < node.propertyCount; j++)
+        {
+            const PropertyRecord &property = pView.GetProperty(node.firstProperty + j);
+            pOut << YAML::Key << pView.GetString(property.nameOffset) << YAML::Value << YAML::Load(pView.GetBlob(property));
+        }
+
+        pOut << YAML::EndMap << YAML::EndMap;
+    }
+
+    pOut << YAML::EndMap << YAML::EndMap;
+}
+
+bool SceneFile::ConvertFile(const std::string &pSrcPath, const std::string &pDstPath)
+{
+    MappedFile file;
+    if (!file.Open(pSrcPath))
+    {
+        RIO_LOG("[SCENEFILE] Failed to load %s\n", pSrcPath.c_str());
+        return false;
+    }
+
+    bool result = false;
+
+    if (IsBinary(file.GetData(), file.GetSize()))
+    {
+        View view;
+        if (view.Initialize(file.GetData(), file.GetSize()))
+        {
+            YAML::Emitter outYaml;
+            ConvertBinaryToYaml(view, outYaml);
+            result = WriteFile(pDstPath, outYaml.c_str(), outYaml.size());
+        }
+    }
+    else
+    {
+        std::vector<u8> binary;
+        if (ConvertYamlToBinary(YAML::Load(std::string(reinterpret_cast<const char *>(file.GetData()), file.GetSize())), &binary))
+            result = WriteFile(pDstPath, binary.data(), binary.size());
+    }
+
+    RIO_LOG("[SCENEFILE] Converted %s to %s: %s\n", pSrcPath.c_str(), pDstPath.c_str(), result ? "ok" : "failed");
+    return result;
+}
+
+// On desktop the data goes to a temporary file first, which then replaces pPath.
+// A crash or a failed write midway leaves the old file as it was.
+// The save thread calls this too, so it writes through its own stream instead of rio's shared native FileDevice.
+bool SceneFile::WriteFile(const std::string &pPath, const void *pData, size_t pSize)
+{
+#if RIO_IS_WIN
+    const std::string writePath = pPath + ".tmp";
+#else
+    const std::string &writePath = pPath;
+#endif // RIO_IS_WIN
+
+    std::ofstream file(writePath, std::ios::binary | std::ios::trunc);
+
+    if (!file.is_open())
+    {
+        RIO_LOG("[SCENEFILE] Failed to open %s for writing\n", writePath.c_str());
+        return false;
+    }
+
+    file.write(static_cast<const char *>(pData), std::streamsize(pSize));
+    file.close();
+
+    bool result = !file.fail();
+
+#if RIO_IS_WIN
+    std::error_code errorCode;
+
+    if (result)
+        std::filesystem::rename(writePath, pPath, errorCode);
+
+    if (!result || errorCode)
+    {
+        RIO_LOG("[SCENEFILE] Failed to write %s\n", pPath.c_str());
+        std::filesystem::remove(writePath, errorCode);
+        return false;
+    }
+#endif // RIO_IS_WIN
+
+    return result;
+}
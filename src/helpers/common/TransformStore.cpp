@@ -0,0 +1,285 @@
+#include <helpers/common/TransformStore.h>
+#include <helpers/common/MatrixBatch.h>
+#include <algorithm>
+
+TransformStore::Handle TransformStore::Create(const rio::Vector3f &pPos, const rio::Vector3f &pRot, const rio::Vector3f &pScale)
+{
+    Handle handle;
+
+    if (!mFreeHandles.empty())
+    {
+        handle = mFreeHandles.back();
+        mFreeHandles.pop_back();
+    }
+    else
+    {
+        handle = mHandleToIndex.size();
+        mHandleToIndex.push_back(cInvalidIndex);
+        mChildren.emplace_back();
+    }
+
+    u32 index = mPositions.size();
+
+    mPositions.push_back(pPos);
+    mRotations.push_back(pRot);
+    mScales.push_back(pScale);
+    mWorldMatrices.emplace_back();
+    mWorldVersions.push_back(0);
+    mDirty.push_back(true);
+    mParents.push_back(cInvalidHandle);
+    mParentVersions.push_back(0);
+    mIndexToHandle.push_back(handle);
+
+    mHandleToIndex[handle] = index;
+    mOrderDirty = true;
+
+    return handle;
+}
+
+void TransformStore::Destroy(Handle pHandle)
+{
+    if (!IsValid(pHandle))
+        return;
+
+    // Children become roots, their local transform is kept as is.
+    for (Handle child : mChildren[pHandle])
+    {
+        u32 childIndex = mHandleToIndex[child];
+        mParents[childIndex] = cInvalidHandle;
+        mDirty[childIndex] = true;
+    }
+
+    mChildren[pHandle].clear();
+    SetParent(pHandle, cInvalidHandle);
+
+    u32 index = mHandleToIndex[pHandle];
+    u32 lastIndex = mPositions.size() - 1;
+
+    // Keep the arrays dense by moving the last element into the freed slot.
+    if (index != lastIndex)
+    {
+        mPositions[index] = mPositions[lastIndex];
+        mRotations[index] = mRotations[lastIndex];
+        mScales[index] = mScales[lastIndex];
+        mWorldMatrices[index] = mWorldMatrices[lastIndex];
+        mWorldVersions[index] = mWorldVersions[lastIndex];
+        mDirty[index] = mDirty[lastIndex];
+        mParents[index] = mParents[lastIndex];
+        mParentVersions[index] = mParentVersions[lastIndex];
+
+        Handle movedHandle = mIndexToHandle[lastIndex];
+        mIndexToHandle[index] = movedHandle;
+        mHandleToIndex[movedHandle] = index;
+    }
+
+    mPositions.pop_back();
+    mRotations.pop_back();
+    mScales.pop_back();
+    mWorldMatrices.pop_back();
+    mWorldVersions.pop_back();
+    mDirty.pop_back();
+    mParents.pop_back();
+    mParentVersions.pop_back();
+    mIndexToHandle.pop_back();
+
+    mHandleToIndex[pHandle] = cInvalidIndex;
+    mFreeHandles.push_back(pHandle);
+    mOrderDirty = true;
+}
+
+bool TransformStore::SetParent(Handle pHandle, Handle pParent)
+{
+    if (!IsValid(pHandle))
+        return false;
+
+    if (pParent != cInvalidHandle)
+    {
+        if (!IsValid(pParent))
+            return false;
+
+        // Refuse to parent a transform to itself or to one of its own children.
+        for (Handle ancestor = pParent; ancestor != cInvalidHandle; ancestor = GetParent(ancestor))
+        {
+            if (ancestor == pHandle)
+                return false;
+        }
+    }
+
+    u32 index = mHandleToIndex[pHandle];
+    Handle oldParent = mParents[index];
+
+    if (oldParent == pParent)
+        return true;
+
+    if (oldParent != cInvalidHandle)
+    {
+        std::vector<Handle> &siblings = mChildren[oldParent];
+        siblings.erase(std::remove(siblings.begin(), siblings.end(), pHandle), siblings.end());
+    }
+
+    if (pParent != cInvalidHandle)
+        mChildren[pParent].push_back(pHandle);
+
+    mParents[index] = pParent;
+    mDirty[index] = true;
+    mOrderDirty = true;
+
+    return true;
+}
+
+void TransformStore::UpdateWorldMatrix(u32 pIndex)
+{
+    u32 parentIndex = GetParentIndex(pIndex);
+
+    if (parentIndex == cInvalidIndex)
+    {
+        mWorldMatrices[pIndex].makeSRT(mScales[pIndex], mRotations[pIndex], mPositions[pIndex]);
+    }
+    else
+    {
+        rio::Matrix34f localMatrix;
+        localMatrix.makeSRT(mScales[pIndex], mRotations[pIndex], mPositions[pIndex]);
+
+        mWorldMatrices[pIndex].setMul(mWorldMatrices[parentIndex], localMatrix);
+        mParentVersions[pIndex] = mWorldVersions[parentIndex];
+    }
+
+    mWorldVersions[pIndex]++;
+    mDirty[pIndex] = false;
+    mChangedHandles.push_back(mIndexToHandle[pIndex]);
+}
+
+void TransformStore::ResolveWorldMatrix(u32 pIndex)
+{
+    u32 parentIndex = GetParentIndex(pIndex);
+
+    if (parentIndex != cInvalidIndex)
+        ResolveWorldMatrix(parentIndex);
+
+    if (IsWorldMatrixStale(pIndex, parentIndex))
+        UpdateWorldMatrix(pIndex);
+}
+
+void TransformStore::RebuildOrder()
+{
+    u32 count = mPositions.size();
+
+    mOrder.clear();
+    mOrder.reserve(count);
+    mLevelStarts.clear();
+
+    for (u32 i = 0; i < count; i++)
+    {
+        if (mParents[i] == cInvalidHandle)
+            mOrder.push_back(i);
+    }
+
+    // Every level is the children of the one before it.
+    u32 levelStart = 0;
+
+    while (levelStart < mOrder.size())
+    {
+        u32 levelEnd = mOrder.size();
+        mLevelStarts.push_back(levelStart);
+
+        for (u32 i = levelStart; i < levelEnd; i++)
+        {
+            for (Handle child : mChildren[mIndexToHandle[mOrder[i]]])
+                mOrder.push_back(mHandleToIndex[child]);
+        }
+
+        levelStart = levelEnd;
+    }
+
+    mLevelStarts.push_back(mOrder.size());
+    mOrderDirty = false;
+}
+
+u32 TransformStore::UpdateWorldMatrices()
+{
+    if (mOrderDirty)
+        RebuildOrder();
+
+    u32 updated = 0;
+
+    // A level only starts once the one above it is done, so a parent is always rebuilt before we check its children against it.
+    for (u32 level = 0; level + 1 < mLevelStarts.size(); level++)
+    {
+        mBatchLocals.clear();
+        mBatchParents.clear();
+        mBatchWorlds.clear();
+        mBatchIndices.clear();
+
+        for (u32 i = mLevelStarts[level]; i < mLevelStarts[level + 1]; i++)
+        {
+            u32 index = mOrder[i];
+            u32 parentIndex = GetParentIndex(index);
+
+            if (!IsWorldMatrixStale(index, parentIndex))
+                continue;
+
+            updated++;
+
+            if (parentIndex == cInvalidIndex)
+            {
+                UpdateWorldMatrix(index);
+                continue;
+            }
+
+            mBatchLocals.emplace_back();
+            mBatchLocals.back().makeSRT(mScales[index], mRotations[index], mPositions[index]);
+            mBatchParents.push_back(&mWorldMatrices[parentIndex]);
+            mBatchWorlds.push_back(&mWorldMatrices[index]);
+            mBatchIndices.push_back(index);
+        }
+
+        if (mBatchIndices.empty())
+            continue;
+
+        MatrixBatch::Mul(MatrixBatch::Stream(mBatchParents.data()), MatrixBatch::Stream(mBatchLocals.data(), sizeof(rio::Matrix34f)),
+                         MatrixBatch::Stream(mBatchWorlds.data()), mBatchIndices.size());
+
+        for (u32 index : mBatchIndices)
+        {
+            mParentVersions[index] = mWorldVersions[GetParentIndex(index)];
+            mWorldVersions[index]++;
+            mDirty[index] = false;
+            mChangedHandles.push_back(mIndexToHandle[index]);
+        }
+    }
+
+    return updated;
+}
+
+bool TransformStore::SetPosition(Handle pHandle, const rio::Vector3f &pPos)
+{
+    u32 index = mHandleToIndex[pHandle];
+    if (IsEqual(mPositions[index], pPos))
+        return false;
+
+    mPositions[index] = pPos;
+    mDirty[index] = true;
+    return true;
+}
+
+bool TransformStore::SetRotation(Handle pHandle, const rio::Vector3f &pRot)
+{
+    u32 index = mHandleToIndex[pHandle];
+    if (IsEqual(mRotations[index], pRot))
+        return false;
+
+    mRotations[index] = pRot;
+    mDirty[index] = true;
+    return true;
+}
+
+bool TransformStore::SetScale(Handle pHandle, const rio::Vector3f &pScale)
+{
+    u32 index = mHandleToIndex[pHandle];
+    if (IsEqual(mScales[index], pScale))
+        return false;
+
+    mScales[index] = pScale;
+    mDirty[index] = true;
+    return true;
+}
@@ -0,0 +1,309 @@
+#include <helpers/common/UniformRing.h>
+#include <gpu/rio_Drawer.h>
+#include <misc/rio_MemUtil.h>
+
+#include <algorithm>
+
+#if RIO_IS_WIN
+#include <GL/glew.h>
+#endif // RIO_IS_WIN
+
+#if RIO_IS_CAFE
+#include <gx2/mem.h>
+#include <gx2/shaders.h>
+#endif // RIO_IS_CAFE
+
+UniformRing::~UniformRing()
+{
+    DestroyBuffer();
+}
+
+bool UniformRing::Initialize(u32 pRegionSize)
+{
+#if RIO_IS_WIN
+    // Every entry has to start on the uniform buffer offset alignment to be bound as a range.
+    GLint alignment = 0;
+    RIO_GL_CALL(glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment));
+    mAlignment = u32(alignment);
+
+    mPersistent = GLEW_VERSION_4_5 || (GLEW_ARB_buffer_storage && GLEW_ARB_direct_state_access);
+    if (!mPersistent)
+        RIO_LOG("[UNIFORMRING] No persistent buffer mapping, mapping every region for its frame instead.\n");
+#else
+    mAlignment = rio::Drawer::cUniformBlockAlignment;
+#endif
+
+    return CreateBuffer(pRegionSize);
+}
+
+u32 UniformRing::GetStride(u32 pSize) const
+{
+    return (pSize + mAlignment - 1) / mAlignment * mAlignment;
+}
+
+// Doubles the regions. If that much memory can't be had, the ring goes back to its old size for good,
+// so only the entries that don't fit are dropped instead of every one of them.
+void UniformRing::Grow()
+{
+    u32 oldRegionSize = mRegionSize;
+    u32 regionSize = mRegionSize * 2;
+    RIO_LOG("[UNIFORMRING] Out of space, growing regions to %u bytes.\n", regionSize);
+
+    DestroyBuffer();
+
+    if (!CreateBuffer(regionSize))
+    {
+        RIO_LOG("[UNIFORMRING] Failed to grow, keeping regions of %u bytes.\n", oldRegionSize);
+        mGrowFailed = true;
+
+        if (!CreateBuffer(oldRegionSize))
+            RIO_LOG("[UNIFORMRING] Failed to restore the old buffer!!\n");
+    }
+
+    mRegion = 0;
+}
+
+#if RIO_IS_WIN
+
+bool UniformRing::CreateBuffer(u32 pRegionSize)
+{
+    mRegionSize = GetStride(pRegionSize);
+
+    u32 size = mRegionSize * cRegionCount;
+
+    if (!mPersistent)
+    {
+        // The copy target keeps the uniform buffer bindings of rio's blocks untouched.
+        RIO_GL_CALL(glGenBuffers(1, &mHandle));
+        RIO_GL_CALL(glBindBuffer(GL_COPY_WRITE_BUFFER, mHandle));
+        glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+
+        if (glGetError() != GL_NO_ERROR)
+        {
+            RIO_LOG("[UNIFORMRING] Failed to allocate %u bytes.\n", size);
+            DestroyBuffer();
+            return false;
+        }
+
+        RIO_LOG("[UNIFORMRING] Allocated %u regions of %u bytes.\n", cRegionCount, mRegionSize);
+        return true;
+    }
+
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    RIO_GL_CALL(glCreateBuffers(1, &mHandle));
+    RIO_GL_CALL(glNamedBufferStorage(mHandle, size, nullptr, flags));
+    mpData = static_cast<u8 *>(glMapNamedBufferRange(mHandle, 0, size, flags));
+
+    if (mpData == nullptr)
+    {
+        RIO_LOG("[UNIFORMRING] Failed to map %u bytes.\n", size);
+        DestroyBuffer();
+        return false;
+    }
+
+    RIO_LOG("[UNIFORMRING] Mapped %u regions of %u bytes.\n", cRegionCount, mRegionSize);
+    return true;
+}
+
+void UniformRing::DestroyBuffer()
+{
+    for (GLsync &fence : mFences)
+    {
+        if (fence)
+        {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+
+    if (mHandle != GL_NONE)
+    {
+        if (mpData)
+            RIO_GL_CALL(glUnmapNamedBuffer(mHandle));
+        else if (mpRegionData)
+            FinishWrites();
+
+        RIO_GL_CALL(glDeleteBuffers(1, &mHandle));
+        mHandle = GL_NONE;
+    }
+
+    mpData = nullptr;
+    mpRegionData = nullptr;
+}
+
+void UniformRing::BeginFrame()
+{
+    if (mOverflowed && !mGrowFailed)
+    {
+        // Nothing is in flight once every fence has passed, the buffer can be replaced right away.
+        for (GLsync &fence : mFences)
+        {
+            if (fence)
+                glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        }
+
+        Grow();
+    }
+
+    mOverflowed = false;
+
+    GLsync &fence = mFences[mRegion];
+    if (fence)
+    {
+        // Usually long signaled, the region was last read cRegionCount - 1 frames ago.
+        if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+        {
+            mWaitCount++;
+            glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        }
+
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    mUsed = 0;
+
+    if (mHandle == GL_NONE)
+        return;
+
+    if (mPersistent)
+    {
+        mpRegionData = mpData + GetRegionStart();
+        return;
+    }
+
+    // The fence above already covers the GPU, so the driver doesn't have to wait for it again.
+    RIO_GL_CALL(glBindBuffer(GL_COPY_WRITE_BUFFER, mHandle));
+    mpRegionData = static_cast<u8 *>(glMapBufferRange(GL_COPY_WRITE_BUFFER, GetRegionStart(), mRegionSize, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+
+    if (mpRegionData == nullptr)
+        RIO_LOG("[UNIFORMRING] Failed to map region %u, nothing is drawn from the ring this frame.\n", mRegion);
+}
+
+// A buffer that isn't mapped persistently can't be read by draws while it is mapped.
+void UniformRing::FinishWrites()
+{
+    if (mpRegionData && !mPersistent)
+    {
+        RIO_GL_CALL(glBindBuffer(GL_COPY_WRITE_BUFFER, mHandle));
+        RIO_GL_CALL(glUnmapBuffer(GL_COPY_WRITE_BUFFER));
+    }
+
+    mpRegionData = nullptr;
+}
+
+void UniformRing::EndFrame()
+{
+    if (mHandle != GL_NONE)
+        mFences[mRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    mLastFrameSize = std::min<u32>(mUsed, mRegionSize);
+    mRegion = (mRegion + 1) % cRegionCount;
+}
+
+void UniformRing::AttachShader(const rio::Shader *pShader, const char *pBlockName)
+{
+    // rio::Shader does not expose its program, take it from the GL state instead.
+    pShader->bind();
+    GLint program = 0;
+    RIO_GL_CALL(glGetIntegerv(GL_CURRENT_PROGRAM, &program));
+
+    u32 blockIndex = glGetUniformBlockIndex(program, pBlockName);
+    if (blockIndex != GL_INVALID_INDEX)
+        RIO_GL_CALL(glUniformBlockBinding(program, blockIndex, cBinding));
+}
+
+void UniformRing::Bind(u32 pOffset, u32 pSize, u32 pVSIndex, u32 pFSIndex) const
+{
+    RIO_GL_CALL(glBindBufferRange(GL_UNIFORM_BUFFER, cBinding, mHandle, GetRegionStart() + pOffset, pSize));
+}
+
+#else
+
+// GX2 reads uniform blocks straight from memory. There are no fences, rio waits for the flip every frame,
+// so the GPU is never more than a frame behind and the oldest region is always free again.
+bool UniformRing::CreateBuffer(u32 pRegionSize)
+{
+    mRegionSize = GetStride(pRegionSize);
+    mpData = static_cast<u8 *>(rio::MemUtil::alloc(mRegionSize * cRegionCount, mAlignment));
+
+    return mpData != nullptr;
+}
+
+void UniformRing::DestroyBuffer()
+{
+    if (mpData)
+        rio::MemUtil::free(mpData);
+
+    mpData = nullptr;
+    mpRegionData = nullptr;
+}
+
+void UniformRing::BeginFrame()
+{
+    if (mOverflowed && !mGrowFailed)
+    {
+        // Waits for every queued draw, some of them still read from the old buffer.
+        GX2DrawDone();
+
+        Grow();
+    }
+
+    mOverflowed = false;
+
+    mUsed = 0;
+
+    if (mpData)
+        mpRegionData = mpData + GetRegionStart();
+}
+
+void UniformRing::FinishWrites()
+{
+    mpRegionData = nullptr;
+}
+
+void UniformRing::EndFrame()
+{
+    mLastFrameSize = std::min<u32>(mUsed, mRegionSize);
+    mRegion = (mRegion + 1) % cRegionCount;
+}
+
+void UniformRing::AttachShader(const rio::Shader *pShader, const char *pBlockName)
+{
+}
+
+void UniformRing::Bind(u32 pOffset, u32 pSize, u32 pVSIndex, u32 pFSIndex) const
+{
+    u8 *data = mpData + GetRegionStart() + pOffset;
+
+    GX2Invalidate(GX2_INVALIDATE_MODE_CPU_UNIFORM_BLOCK, data, pSize);
+
+    if (pVSIndex != u32(-1))
+        GX2SetVertexUniformBlock(pVSIndex, pSize, data);
+
+    if (pFSIndex != u32(-1))
+        GX2SetPixelUniformBlock(pFSIndex, pSize, data);
+}
+
+#endif // RIO_IS_WIN
+
+u8 *UniformRing::Allocate(u32 pCount, u32 pSize, u32 *pOffset)
+{
+    if (mpRegionData == nullptr)
+        return nullptr;
+
+    u32 size = GetStride(pSize) * pCount;
+    u32 offset = mUsed.fetch_add(size);
+
+    if (offset + size > mRegionSize)
+    {
+        // Read on the next BeginFrame(), on the main thread.
+        mOverflowed = true;
+        mOverflowCount++;
+        return nullptr;
+    }
+
+    *pOffset = offset;
+    return mpRegionData + offset;
+}
@@ -7,6 +7,8 @@
 #include <imgui_impl_opengl3.h>
 #include <gfx/rio_PrimitiveRenderer.h>
 #include <helpers/common/NodeMgr.h>
+#include <helpers/common/FrameUniformMgr.h>
+#include <helpers/common/MappedFile.h>
 #include <gfx/rio_Window.h>
 #include <iostream>
 #include <gpu/rio_RenderBuffer.h>
@@ -117,6 +119,9 @@ void EditorMgr::UpdateTexturesDirCache()
         mTextureCachedContents.clear();
         mTextures.clear();
 
+        f32 loadTimeMs = 0.f;
+        size_t loadedSize = 0;
+
         for (const auto &fileEntry : std::filesystem::directory_iterator(mTextureFolderPath))
         {
             // We're only loading .rtx, since that is the file format for pc.
@@ -125,34 +130,26 @@ void EditorMgr::UpdateTexturesDirCache()
 
             RIO_LOG("[EDITORMGR] Loading texture %s..\n", fileEntry.path().filename().c_str());
 
-            std::ifstream file(fileEntry.path(), std::ios::binary);
+            // Texture2D uploads straight from the mapping, the file is never copied to the heap.
+            MappedFile file;
 
-            if (!file)
+            if (!file.Open(fileEntry.path().string()))
             {
                 RIO_LOG("[EDITORMGR] Failed to open texture file: %s\n", fileEntry.path().filename().c_str());
                 continue;
             }
 
-            u8 *fileBuffer = new u8[fileEntry.file_size()];
-
-            file.read(reinterpret_cast<char *>(fileBuffer), fileEntry.file_size());
-            file.close();
-
-            if (!file)
-            {
-                RIO_LOG("[EDITORMGR] Failed to read texture file: %s\n", fileEntry.path().filename().c_str());
-                delete[] fileBuffer;
-                continue;
-            }
-
             // Create rio::Texture2D object
-            std::unique_ptr<rio::Texture2D> texture = std::make_unique<rio::Texture2D>(fileBuffer, fileEntry.file_size());
+            std::unique_ptr<rio::Texture2D> texture = std::make_unique<rio::Texture2D>(file.GetData(), file.GetSize());
 
             mTextures[fileEntry.path().string()] = std::move(texture);
             mTextureCachedContents.push_back(fileEntry.path());
 
-            delete[] fileBuffer;
+            loadTimeMs += file.GetLoadTimeMs();
+            loadedSize += file.GetSize();
         }
+
+        RIO_LOG("[EDITORMGR] Loaded %zu textures (%zu KiB) in %.2f ms.\n", mTextures.size(), loadedSize / 1024, loadTimeMs);
     }
 }
 
@@ -191,7 +188,10 @@ void EditorMgr::CreateEditorUI()
                     NodeMgr::instance()->ClearAllNodes();
 
                 if (ImGui::MenuItem("Save Scene", "Ctrl+S"))
-                    NodeMgr::instance()->SaveToFile();
+                    NodeMgr::instance()->SaveToFileAsync();
+
+                if (ImGui::MenuItem("Export Binary Scene"))
+                    NodeMgr::instance()->SaveToFileAsync(NodeMgr::SCENE_FORMAT_BINARY);
 
                 ImGui::MenuItem("Open Scene", "Ctrl+O");
                 ImGui::EndMenu();
@@ -211,12 +211,33 @@ void EditorMgr::CreateEditorUI()
                 ImGui::EndMenu();
             }
 
+            FrameUniformMgr *frameUniforms = FrameUniformMgr::instance();
+
             if (ImGui::BeginMenu("Window"))
             {
                 ImGui::MenuItem(mTextureWindowName.c_str(), NULL, &mTextureWindowEnabled);
+
+                bool cullingEnabled = frameUniforms->IsCullingEnabled();
+                if (ImGui::MenuItem("Frustum Culling", NULL, &cullingEnabled))
+                    frameUniforms->SetCullingEnabled(cullingEnabled);
+
                 ImGui::EndMenu();
             }
 
+            const FrameUniformMgr::CullStats &cullStats = frameUniforms->GetCullStats();
+            ImGui::TextDisabled("Drawn: %u, culled: %u", cullStats.drawn, cullStats.culled);
+
+            NodeMgr *nodeMgr = NodeMgr::instance();
+
+            if (nodeMgr->IsStreaming())
+                ImGui::TextDisabled("Loading scene... %.0f%%", nodeMgr->GetStreamingProgress() * 100.f);
+            else if (nodeMgr->IsSaving())
+                ImGui::TextDisabled("Saving scene... %.0f%%", nodeMgr->GetSaveProgress() * 100.f);
+            else if (nodeMgr->GetSaveCount() > 0 && nodeMgr->GetLastSaveResult())
+                ImGui::TextDisabled("Scene saved in %.1f ms", nodeMgr->GetLastSaveTimeMs());
+            else if (nodeMgr->GetSaveCount() > 0)
+                ImGui::TextDisabled("Scene save failed");
+
             ImGui::EndMainMenuBar();
         }
 
@@ -258,7 +279,7 @@ void EditorMgr::CreateEditorUI()
                         rio::PrimitiveRenderer::instance()->begin();
 
                         rio::PrimitiveRenderer::CubeArg cubeArg;
-                        cubeArg.setCenter(mSelectedNode->GetPosition());
+                        cubeArg.setCenter(mSelectedNode->GetWorldPosition());
                         cubeArg.setSize(mSelectedNode->GetScale());
                         cubeArg.setColor({1, 1, 1, 1});
 
@@ -446,7 +467,18 @@ void EditorMgr::CreateNodePropertiesMenu()
         if (ImGui::CollapsingHeader("Properties"))
         {
             for (const auto &property : selectedNode->properties)
+            {
+                // The group reports an edit if any widget of the property changed its value.
+                ImGui::BeginGroup();
                 property->CreatePropertiesMenu();
+                ImGui::EndGroup();
+
+                if (ImGui::IsItemEdited())
+                {
+                    property->MarkDirty();
+                    selectedNode->MarkBoundsDirty();
+                }
+            }
         }
     }
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include <helpers/properties/MiiHeadProperty.h>
 #include <helpers/common/FFLMgr.h>
+#include <helpers/common/FrameUniformMgr.h>
+#include <helpers/common/MiiHeadBatch.h>
 #include <helpers/common/NodeMgr.h>
 #include <gpu/rio_RenderState.h>
 #include <gpu/rio_Shader.h>
@@ -11,10 +13,25 @@
 #include <misc/cpp/imgui_stdlib.h>
 
 #include <cstdint>
+#include <chrono>
+
+namespace
+{
+    // FFL head models are far bigger than a node unit, scale them down to fit.
+    const f32 cMiiHeadScale = 1.f / 32.f;
+
+    typedef std::chrono::steady_clock Clock;
+
+    inline f32 GetElapsedMs(Clock::time_point pStart)
+    {
+        return std::chrono::duration<f32, std::milli>(Clock::now() - pStart).count();
+    }
+}
 
 MiiHeadProperty::~MiiHeadProperty()
 {
-    FFLDeleteCharModel(&mCharModel);
+    if (mpBatch)
+        FFLMgr::instance()->ReleaseMiiHeadBatch(mpBatch, &mNodeMtx);
 }
 
 YAML::Node MiiHeadProperty::Save()
@@ -29,14 +46,9 @@ YAML::Node MiiHeadProperty::Save()
 
 void MiiHeadProperty::LoadStoreData()
 {
-    rio::RawErrorCode errorCode;
-    mStoreData = FFLMgr::instance()->GetStoreDataFromFile(mMiiDataFile, &errorCode);
-
-    if (sizeof(mStoreData) != sizeof(FFLStoreData))
-    {
-        RIO_LOG("[MIIHEAD] FFLStoreData size does not match with current store data size!!");
+    mStoreDataValid = FFLMgr::instance()->GetStoreDataFromFile(mMiiDataFile, &mStoreData);
+    if (!mStoreDataValid)
         return;
-    }
 
     GetAdditionalData();
 }
@@ -47,105 +59,130 @@ void MiiHeadProperty::Load(YAML::Node node)
     SetPropertyID(node["propertyId"].as<int>());
 }
 
-void MiiHeadProperty::Start()
+// Store data read and decode. Runs on a worker thread while the other Miis load.
+void MiiHeadProperty::StartAsync()
 {
-    LoadStoreData();
+    Clock::time_point start = Clock::now();
 
-    // TODO: make most of this customizable.
+    LoadStoreData();
 
-    mCharModelSource.dataSource = FFL_DATA_SOURCE_STORE_DATA;
-    mCharModelSource.pBuffer = &mStoreData;
-    mCharModelSource.index = 0;
-    mCharModelDesc.resolution = FFLMgr::instance()->GetGlobalResolution();
-    mCharModelDesc.expressionFlag = FFL_EXPRESSION_FLAG_NORMAL;
-    mCharModelDesc.resourceType = FFL_RESOURCE_TYPE_HIGH;
-    mCharModelDesc.modelFlag = 1 << 0 | 1 << 1 | 1 << 2;
+    mLoadTimeMs = GetElapsedMs(start);
+}
 
-    if (!FFLInitCharModelCPUStep(&mCharModel, &mCharModelSource, &mCharModelDesc) == FFL_RESULT_OK)
-    {
-        RIO_LOG("[MIIHEAD] InitCharModelCPUStep failed!!\n");
+// Building the CharModel allocates the face textures and reads from the shared FFL resource file,
+// so everything from here on stays on the GL thread.
+void MiiHeadProperty::Start()
+{
+    // Nothing to build a CharModel from, the read already logged why.
+    if (!mStoreDataValid)
         return;
-    }
 
-    mShader.initialize();
-    mShader.bind(false);
+    u32 cacheMisses = FFLMgr::instance()->GetCharModelCacheMisses();
 
-    mpShader = &mShader;
+    AcquireBatch();
 
-    FFLInitCharModelGPUStep(&mCharModel);
-    rio::Window::instance()->makeContextCurrent();
+    if (!mpBatch)
+        return;
 
-    auto mainCamera = NodeMgr::instance()->GetNodeByKey("mapCamera");
+    // Heads reusing a cached CharModel skip both steps.
+    bool cached = cacheMisses == FFLMgr::instance()->GetCharModelCacheMisses();
+    mCPUStepTimeMs = cached ? 0.f : mpBatch->GetCPUStepTimeMs();
+    mGPUStepTimeMs = cached ? 0.f : mpBatch->GetGPUStepTimeMs();
 
-    mainCameraProperty = mainCamera->GetProperty<CameraProperty>().at(0);
+    RIO_LOG("[MIIHEAD] Loaded %s in %.2f ms (read: %.2f ms, CPU step: %.2f ms, GPU step: %.2f ms%s)\n",
+            mMiiDataFile.c_str(), mLoadTimeMs + mCPUStepTimeMs + mGPUStepTimeMs, mLoadTimeMs, mCPUStepTimeMs, mGPUStepTimeMs,
+            cached ? ", cached CharModel" : "");
 
     mInitialized = true;
 }
 
-void MiiHeadProperty::Update()
+// Moves this head to the batch matching its current store data and expression.
+// The new batch is acquired before the old one is released, so re-acquiring the same batch never rebuilds its CharModel.
+void MiiHeadProperty::AcquireBatch()
 {
-    rio::BaseMtx34f viewMtx;
-    rio::BaseMtx44f projMtx;
-    rio::Mtx34f nodeMtx;
+    MiiHeadBatch *batch = FFLMgr::instance()->AcquireMiiHeadBatch(mStoreData, mExpressionFlag, &mNodeMtx);
+    if (!batch)
+        return;
 
-    mainCameraProperty->GetCamera().getMatrix(&viewMtx);
-    projMtx = mainCameraProperty->GetProjectionMatrix();
-    nodeMtx.makeSRT(GetParentNode().lock()->GetScale() / 32.f, GetParentNode().lock()->GetRotation(), GetParentNode().lock()->GetPosition());
+    if (mpBatch)
+        FFLMgr::instance()->ReleaseMiiHeadBatch(mpBatch, &mNodeMtx);
 
-    mpShader->bind(true);
-    mpShader->setViewUniform(nodeMtx, viewMtx, projMtx);
+    mpBatch = batch;
+}
 
-    DrawOpa();
-    DrawXlu();
+void MiiHeadProperty::SetExpression(FFLExpressionFlag pExpressionFlag)
+{
+    mExpressionFlag = pExpressionFlag;
+
+    if (mpBatch)
+        AcquireBatch();
 }
 
-void MiiHeadProperty::DrawOpa()
+void MiiHeadProperty::SetStoreData(FFLStoreData pStoreData)
 {
-    rio::RenderState render_state;
-    render_state.setDepthEnable(true, true);
-    render_state.setDepthFunc(rio::Graphics::COMPARE_FUNC_LEQUAL);
-    render_state.setBlendEnable(false);
-    render_state.setColorMask(true, true, true, true);
-    render_state.apply();
+    mStoreData = pStoreData;
+    mStoreDataValid = true;
+    GetAdditionalData();
 
-    FFLDrawOpa(&mCharModel);
+    if (mpBatch)
+        AcquireBatch();
 }
 
-void MiiHeadProperty::DrawXlu()
+void MiiHeadProperty::UpdateNodeMatrix()
 {
-    {
-        rio::RenderState render_state;
-        render_state.setDepthEnable(true, false);
-        render_state.setDepthFunc(rio::Graphics::COMPARE_FUNC_LEQUAL);
-        render_state.setBlendEnable(true);
-        render_state.setBlendFactorSrcRGB(rio::Graphics::BLEND_MODE_SRC_ALPHA);
-        render_state.setBlendFactorDstRGB(rio::Graphics::BLEND_MODE_ONE_MINUS_SRC_ALPHA);
-        render_state.setBlendEquation(rio::Graphics::BLEND_FUNC_ADD);
-        render_state.setColorMask(true, true, true, false);
-        render_state.apply();
-
-        mpShader->applyAlphaTestEnable();
-
-        FFLDrawXlu(&mCharModel);
-    }
+    std::shared_ptr<Node> parentNode = GetParentNode().lock();
+
+    u32 worldVersion = parentNode->GetWorldMatrixVersion();
+    if (worldVersion == mNodeMtxVersion)
+        return;
 
+    mNodeMtx = parentNode->GetWorldMatrix();
+
+    // Same as makeSRT(scale / 32, rotation, position), the scale only affects the 3x3 part.
+    for (int row = 0; row < 3; row++)
     {
-        rio::RenderState render_state;
-        render_state.setDepthEnable(true, true);
-        render_state.setDepthFunc(rio::Graphics::COMPARE_FUNC_LEQUAL);
-        render_state.setBlendEnable(true);
-        render_state.setBlendFactorSrcRGB(rio::Graphics::BLEND_MODE_ONE_MINUS_DST_ALPHA);
-        render_state.setBlendFactorDstRGB(rio::Graphics::BLEND_MODE_DST_ALPHA);
-        render_state.setBlendFactorSrcAlpha(rio::Graphics::BLEND_MODE_ONE);
-        render_state.setBlendFactorDstAlpha(rio::Graphics::BLEND_MODE_ONE);
-        render_state.setBlendEquation(rio::Graphics::BLEND_FUNC_ADD);
-        render_state.setColorMask(true, true, true, true);
-        render_state.apply();
-
-        mpShader->applyAlphaTestEnable();
-
-        FFLDrawXlu(&mCharModel);
+        for (int column = 0; column < 3; column++)
+            mNodeMtx.m[row][column] *= cMiiHeadScale;
     }
+
+    mNodeMtxVersion = worldVersion;
+}
+
+void MiiHeadProperty::UpdateAsync()
+{
+    UpdateNodeMatrix();
+}
+
+BoundingBox MiiHeadProperty::GetWorldBounds() const
+{
+    if (!mpBatch || mNodeMtxVersion == 0)
+        return BoundingBox();
+
+    return mpBatch->GetBounds().Transform(mNodeMtx);
+}
+
+// Only the first head of a batch draws, and it draws every visible instance of it.
+// The FFL shader takes plain uniforms, so it gets the frame's matrices instead of the shared view block.
+void MiiHeadProperty::Update()
+{
+    FrameUniformMgr *frameUniforms = FrameUniformMgr::instance();
+    if (!mpBatch || !mpBatch->IsLeader(&mNodeMtx) || !frameUniforms->IsValid())
+        return;
+
+    mpBatch->DrawOpa(frameUniforms->GetViewMtx(), frameUniforms->GetProjMtx(), frameUniforms->GetFrustum());
+
+    u32 visibleCount = mpBatch->GetVisibleInstanceCount();
+    frameUniforms->AddDrawn(visibleCount);
+    frameUniforms->AddCulled(mpBatch->GetInstanceCount() - visibleCount);
+}
+
+void MiiHeadProperty::DrawXlu()
+{
+    FrameUniformMgr *frameUniforms = FrameUniformMgr::instance();
+    if (!mpBatch || !mpBatch->IsLeader(&mNodeMtx) || !frameUniforms->IsValid())
+        return;
+
+    mpBatch->DrawXlu(frameUniforms->GetViewMtx(), frameUniforms->GetProjMtx());
 }
 
 void MiiHeadProperty::CreatePropertiesMenu()
@@ -154,10 +191,26 @@ void MiiHeadProperty::CreatePropertiesMenu()
 
     if (ImGui::CollapsingHeader(label.c_str()))
     {
+        ImGui::Text("Load time: %.2f ms (read: %.2f ms, CPU step: %.2f ms, GPU step: %.2f ms)",
+                    mLoadTimeMs + mCPUStepTimeMs + mGPUStepTimeMs, mLoadTimeMs, mCPUStepTimeMs, mGPUStepTimeMs);
+
+        if (mpBatch)
+        {
+            FFLMgr *fflMgr = FFLMgr::instance();
+
+            ImGui::Text("CharModel shared by %u heads", mpBatch->GetInstanceCount());
+            ImGui::Text("CharModel cache: %zu / %zu MiB (%u hits, %u misses)",
+                        fflMgr->GetCharModelCacheSize() / (1024 * 1024), fflMgr->GetCharModelCacheBudget() / (1024 * 1024),
+                        fflMgr->GetCharModelCacheHits(), fflMgr->GetCharModelCacheMisses());
+
+            const Shader::UniformStats &stats = mpBatch->GetShader()->getUniformStats();
+            ImGui::Text("Shared shader uniforms last frame: %u set, %u skipped", stats.issued, stats.skipped);
+        }
+
         int currentIndex = -1;
         for (int i = 0; i < FFL_EXPRESSION_MAX; ++i)
         {
-            if (expressionEnumFlags[i].value == mCharModelDesc.expressionFlag)
+            if (expressionEnumFlags[i].value == mExpressionFlag)
             {
                 currentIndex = i;
                 break;
@@ -170,7 +223,7 @@ void MiiHeadProperty::CreatePropertiesMenu()
         {
             for (int i = 0; i < FFL_EXPRESSION_MAX; i++)
             {
-                bool isSelected = (mCharModelDesc.expressionFlag == 1 << i);
+                bool isSelected = (mExpressionFlag == 1 << i);
 
                 if (ImGui::Selectable(expressionEnumFlags[i].name, isSelected))
                 {
@@ -190,6 +243,8 @@ void MiiHeadProperty::GetAdditionalData()
 {
     FFLGetAdditionalInfo(&mAdditionalInfo, FFL_DATA_SOURCE_STORE_DATA, &mStoreData, 0, 0);
 
+    mMiiName.clear();
+
     for (auto character : mAdditionalInfo.name)
         mMiiName.push_back(static_cast<char>(character));
 }
\ No newline at end of file
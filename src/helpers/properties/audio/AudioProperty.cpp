@@ -35,12 +35,11 @@ void AudioProperty::Load(YAML::Node node)
 
     Property::SetPropertyID(node["propertyId"].as<int>());
     Property::SetLoggingString("AUDIO");
-
-    rio::AudioMgr::instance()->setListenerMaxDistance(5.f);
 }
 
 void AudioProperty::Start()
 {
+    rio::AudioMgr::instance()->setListenerMaxDistance(5.f);
     LoadAudio();
     mInitialized = true;
 }
@@ -131,7 +130,7 @@ void AudioProperty::Play()
     {
         rio::AudioSfx *sfx = rio::AudioMgr::instance()->getSfx(audioKey->c_str());
         sfx->setVolume(volume);
-        sfx->play(Property::GetParentNode().lock()->GetPosition(), loop);
+        sfx->play(Property::GetParentNode().lock()->GetWorldPosition(), loop);
         break;
     }
     }
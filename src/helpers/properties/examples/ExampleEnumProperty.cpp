@@ -15,6 +15,9 @@ void ExampleEnumProperty::Load(YAML::Node node)
 void ExampleEnumProperty::Start()
 {
     // Start logic here..
+
+    // NodeMgr only updates properties once they are initialized.
+    mInitialized = true;
 }
 
 void ExampleEnumProperty::Update()
@@ -8,6 +8,9 @@ void ExampleProperty::Load(YAML::Node node)
 void ExampleProperty::Start()
 {
     // Start logic here..
+
+    // NodeMgr only updates properties once they are initialized.
+    mInitialized = true;
 }
 
 void ExampleProperty::Update()
@@ -1,10 +1,9 @@
 #include <helpers/properties/gfx/MeshProperty.h>
+#include <helpers/common/FrameUniformMgr.h>
+#include <helpers/common/MatrixBatch.h>
 #include <helpers/common/NodeMgr.h>
 #include <helpers/editor/EditorMgr.h>
 
-__attribute__((aligned(rio::Drawer::cUniformBlockAlignment))) MeshProperty::ViewBlock MeshProperty::sViewBlock;
-__attribute__((aligned(rio::Drawer::cUniformBlockAlignment))) MeshProperty::LightBlock MeshProperty::sLightBlock;
-
 void MeshProperty::Load(YAML::Node node)
 {
     mMeshFileName = node["meshFileName"].as<std::string>();
@@ -22,16 +21,34 @@ void MeshProperty::LoadMesh()
     }
 
     mMdlModel = std::make_unique<rio::mdl::Model>(resModel);
+
+    // Meshes of the model come in the same order as the ones of the resource.
+    const rio::mdl::res::Mesh *resMeshes = resModel->meshes();
+    mMeshBounds.resize(resModel->numMeshes());
+
+    for (u32 i = 0; i < resModel->numMeshes(); i++)
+    {
+        const rio::mdl::res::Vertex *vertices = resMeshes[i].vertices();
+        for (u32 j = 0; j < resMeshes[i].numVertices(); j++)
+            mMeshBounds[i].Add(vertices[j].pos);
+    }
 }
 
-MeshProperty::~MeshProperty()
+// Every mesh has its own world matrix, so each box is transformed on its own before they are merged.
+void MeshProperty::UpdateWorldBounds()
 {
-    rio::MemUtil::free(mModelUniformBlock);
-    rio::MemUtil::free(mModelBlock);
-    rio::MemUtil::free(mUniformBlocks);
+    const rio::mdl::Mesh *const meshes = mMdlModel->meshes();
+
+    mWorldBounds = BoundingBox();
+
+    for (u32 i = 0; i < mMeshBounds.size(); i++)
+        mWorldBounds.Merge(mMeshBounds[i].Transform(meshes[i].worldMtx()));
+}
 
-    delete mpLightUniformBlock;
-    delete mpViewUniformBlock;
+MeshProperty::~MeshProperty()
+{
+    if (mUniformBlocks)
+        rio::MemUtil::free(mUniformBlocks);
 }
 
 void MeshProperty::Start()
@@ -41,27 +58,14 @@ void MeshProperty::Start()
     if (!mMdlModel)
         return;
 
-    rio::Mtx34f nodeMtx;
-    nodeMtx.makeSRT(GetParentNode().lock()->GetScale(), GetParentNode().lock()->GetRotation(), GetParentNode().lock()->GetPosition());
+    std::shared_ptr<Node> parentNode = GetParentNode().lock();
 
-    mMdlModel->setModelWorldMtx(nodeMtx);
-
-    mpViewUniformBlock = new rio::UniformBlock();
-    mpViewUniformBlock->setData(&sViewBlock, sizeof(ViewBlock));
-
-    mCameraProperty = NodeMgr::instance()->GetNodeByKey("mapCamera")->GetProperty<CameraProperty>().at(0);
-
-    rio::Color4f lightColor = {1, 1, 1, 1};
-    sLightBlock.light_color = {lightColor.r, lightColor.g, lightColor.b};
-    sLightBlock.light_pos = {0, 0, 0};
-
-    mpLightUniformBlock = new rio::UniformBlock();
-    mpLightUniformBlock->setDataInvalidate(&sLightBlock, sizeof(LightBlock));
+    mMdlModel->setModelWorldMtx(parentNode->GetWorldMatrix());
+    mWorldMtxVersion = parentNode->GetWorldMatrixVersion();
+    UpdateWorldBounds();
 
     u32 num_meshes = mMdlModel->numMeshes();
 
-    mModelUniformBlock = (rio::UniformBlock *)rio::MemUtil::alloc(num_meshes * sizeof(rio::UniformBlock), 4);
-    mModelBlock = (ModelBlock *)rio::MemUtil::alloc(num_meshes * sizeof(ModelBlock), rio::Drawer::cUniformBlockAlignment);
     mUniformBlocks = (UniformBlocks *)rio::MemUtil::alloc(num_meshes * sizeof(UniformBlocks), 4);
 
     for (u32 i = 0; i < num_meshes; i++)
@@ -91,41 +95,86 @@ void MeshProperty::Start()
             model_block_idx.vs = p_shader->getVertexUniformBlockIndex("cModelBlock");
             model_block_idx.fs = p_shader->getFragmentUniformBlockIndex("cModelBlock");
             model_block_idx.findStage();
-        }
 
-        new (&mModelUniformBlock[i]) rio::UniformBlock(model_block_idx.stage, model_block_idx.vs, model_block_idx.fs);
-        mModelUniformBlock[i].setData(&mModelBlock[i], sizeof(ModelBlock));
+            if (model_block_idx.stage != rio::UniformBlock::STAGE_NONE)
+                UniformRing::AttachShader(p_shader, "cModelBlock");
+        }
 
-        new (&mUniformBlocks[i]) UniformBlocks(view_block_idx, light_block_idx);
+        new (&mUniformBlocks[i]) UniformBlocks(view_block_idx, light_block_idx, model_block_idx);
     }
+
+    mInitialized = true;
 }
 
-void MeshProperty::Update()
+void MeshProperty::UpdateAsync()
 {
-    if (!mCameraProperty)
+    if (!mMdlModel)
+        return;
+
+    // Only push the node matrix down to the meshes when the node actually moved.
+    std::shared_ptr<Node> parentNode = GetParentNode().lock();
+
+    u32 worldVersion = parentNode->GetWorldMatrixVersion();
+    if (worldVersion != mWorldMtxVersion)
+    {
+        mMdlModel->setModelWorldMtx(parentNode->GetWorldMatrix());
+        mWorldMtxVersion = worldVersion;
+        UpdateWorldBounds();
+    }
+
+    // The frame's camera is already set up, so hidden models don't even take space in the ring.
+    FrameUniformMgr *frameUniforms = FrameUniformMgr::instance();
+
+    mVisible = frameUniforms->IsVisible(mWorldBounds);
+    if (!mVisible)
         return;
 
-    sLightBlock.light_color = {1, 1, 1};
-    sLightBlock.light_pos = {0, 0, 0};
+    const rio::mdl::Mesh *const meshes = mMdlModel->meshes();
+    u32 numMeshes = mMdlModel->numMeshes();
 
-    rio::Matrix34f view_mtx;
-    rio::Matrix44f view_proj_mtx;
+    // Mesh world and normal matrices go straight into this frame's part of the draw ring, Update() binds them.
+    UniformRing &ring = frameUniforms->GetDrawRing();
 
-    mCameraProperty->GetCamera().getMatrix(&view_mtx);
+    u8 *data = ring.Allocate(numMeshes, sizeof(ModelBlock), &mModelBlockOffset);
+    if (!data)
+        return;
 
-    // Calculate view-projection matrix (Projection x View)
-    view_proj_mtx.setMul(mCameraProperty->GetProjectionMatrix(), view_mtx);
+    u32 stride = ring.GetStride(sizeof(ModelBlock));
 
-    sViewBlock.view_pos = mCameraProperty->GetParentNode().lock()->GetPosition();
-    sViewBlock.view_proj_mtx = view_proj_mtx;
+    for (u32 i = 0; i < numMeshes; i++)
+        reinterpret_cast<ModelBlock *>(data + i * stride)->model_mtx = meshes[i].worldMtx();
 
-    mpViewUniformBlock->setSubDataInvalidate(&sViewBlock, 0, sizeof(ViewBlock));
-    mpLightUniformBlock->setSubDataInvalidate(&sLightBlock, 0, sizeof(LightBlock));
+    // The ring is write-only memory, so the normal matrices are built from the meshes and not read back from there.
+    if (numMeshes > 0)
+    {
+        MatrixBatch::InverseTranspose(MatrixBatch::Stream(&meshes[0].worldMtx(), sizeof(rio::mdl::Mesh)),
+                                      MatrixBatch::Stream(&reinterpret_cast<ModelBlock *>(data)->normal_mtx, stride), numMeshes);
+    }
 
-    rio::Mtx34f nodeMtx;
-    nodeMtx.makeSRT(GetParentNode().lock()->GetScale(), GetParentNode().lock()->GetRotation(), GetParentNode().lock()->GetPosition());
+    mModelBlockFrame = frameUniforms->GetFrameCount();
+}
 
-    mMdlModel->setModelWorldMtx(nodeMtx);
+void MeshProperty::Update()
+{
+    // The view and light blocks were uploaded once for the whole frame, meshes only bind them.
+    FrameUniformMgr *frameUniforms = FrameUniformMgr::instance();
+    if (!mMdlModel || !frameUniforms->IsValid())
+        return;
+
+    if (!mVisible)
+    {
+        frameUniforms->AddCulled();
+        return;
+    }
+
+    // The draw ring ran out of space this frame, it has grown by the next one.
+    if (mModelBlockFrame != frameUniforms->GetFrameCount())
+        return;
+
+    frameUniforms->AddDrawn();
+
+    const UniformRing &ring = frameUniforms->GetDrawRing();
+    u32 stride = ring.GetStride(sizeof(ModelBlock));
 
     const rio::mdl::Mesh *const meshes = mMdlModel->meshes();
 
@@ -144,24 +193,10 @@ void MeshProperty::Update()
 
         const UniformBlocks &uniform_block_idx = mUniformBlocks[i];
 
-        // Set the ViewBlock index and stage
-        mpViewUniformBlock->setIndex(uniform_block_idx.view_block_idx.vs, uniform_block_idx.view_block_idx.fs);
-        mpViewUniformBlock->setStage(uniform_block_idx.view_block_idx.stage);
-        mpViewUniformBlock->bind();
-
-        // Get mesh world matrix
-        mModelBlock[i].model_mtx = mesh.worldMtx();
-        mModelBlock[i].normal_mtx.setInverseTranspose(mModelBlock[i].model_mtx);
-
-        // Set the LightBlock index and stage
-        mpLightUniformBlock->setIndex(uniform_block_idx.light_block_idx.vs, uniform_block_idx.light_block_idx.fs);
-        mpLightUniformBlock->setStage(uniform_block_idx.light_block_idx.stage);
-        mpLightUniformBlock->bind();
+        frameUniforms->BindViewBlock(uniform_block_idx.view_block_idx.vs, uniform_block_idx.view_block_idx.fs, uniform_block_idx.view_block_idx.stage);
+        frameUniforms->BindLightBlock(uniform_block_idx.light_block_idx.vs, uniform_block_idx.light_block_idx.fs, uniform_block_idx.light_block_idx.stage);
 
-        // Update the ModelBlock uniform
-        mModelUniformBlock[i].setSubDataInvalidate(&mModelBlock[i], 0, 2 * sizeof(rio::Matrix34f));
-        // Bind the ModelBlock uniform
-        mModelUniformBlock[i].bind();
+        ring.Bind(mModelBlockOffset + i * stride, sizeof(ModelBlock), uniform_block_idx.model_block_idx.vs, uniform_block_idx.model_block_idx.fs);
 
         const rio::Shader *shader = material.shader();
 
@@ -1,4 +1,5 @@
 #include <helpers/properties/gfx/PrimitiveProperty.h>
+#include <helpers/common/FrameUniformMgr.h>
 #include <gfx/rio_PrimitiveRenderer.h>
 
 YAML::Node PrimitiveProperty::Save()
@@ -42,21 +43,69 @@ void PrimitiveProperty::Load(YAML::Node node)
 
 void PrimitiveProperty::Start() { mInitialized = true; }
 
+// Same sizes the shapes are drawn with below. Cubes and spheres are centered on the node, axes start there
+// and point along +x, +y and +z, cylinders get twice their height so it doesn't matter where they start.
+BoundingBox PrimitiveProperty::GetWorldBounds(const rio::Vector3f &pWorldPosition, const rio::Vector3f &pScale) const
+{
+    switch (mShapeType)
+    {
+    case SHAPE_TYPE_SPHERE:
+        return BoundingBox::FromCenter(pWorldPosition, {mShapeRadius, mShapeRadius, mShapeRadius});
+    case SHAPE_TYPE_CUBE:
+        return BoundingBox::FromCenter(pWorldPosition, {pScale.x * 0.5f, pScale.y * 0.5f, pScale.z * 0.5f});
+    case SHAPE_TYPE_AXIS:
+    {
+        f32 scale = (pScale.x + pScale.y + pScale.z) / 3;
+
+        BoundingBox box;
+        box.Add(pWorldPosition);
+        box.Add(rio::Vector3f{pWorldPosition.x + scale, pWorldPosition.y + scale, pWorldPosition.z + scale});
+        return box;
+    }
+    case SHAPE_TYPE_CYLINDER:
+    {
+        f32 radius = (pScale.x + pScale.z) / 2;
+        return BoundingBox::FromCenter(pWorldPosition, {radius, pScale.y, radius});
+    }
+    }
+
+    // Unknown shapes are never culled.
+    return BoundingBox();
+}
+
+BoundingBox PrimitiveProperty::GetWorldBounds() const
+{
+    std::shared_ptr<Node> parentNode = GetParentNode().lock();
+    return GetWorldBounds(parentNode->GetWorldPosition(), parentNode->GetScale());
+}
+
 void PrimitiveProperty::Update()
 {
+    std::shared_ptr<Node> parentNode = GetParentNode().lock();
+    rio::Vector3f worldPosition = parentNode->GetWorldPosition();
+
+    FrameUniformMgr *frameUniforms = FrameUniformMgr::instance();
+    if (!frameUniforms->IsVisible(GetWorldBounds(worldPosition, parentNode->GetScale())))
+    {
+        frameUniforms->AddCulled();
+        return;
+    }
+
+    frameUniforms->AddDrawn();
+
     rio::PrimitiveRenderer::instance()->begin();
 
     switch (mShapeType)
     {
     case SHAPE_TYPE_SPHERE:
     {
-        rio::PrimitiveRenderer::instance()->drawSphere8x16(GetParentNode().lock()->GetPosition(), mShapeRadius, mShapeColor);
+        rio::PrimitiveRenderer::instance()->drawSphere8x16(worldPosition, mShapeRadius, mShapeColor);
         break;
     }
     case SHAPE_TYPE_CUBE:
     {
         rio::PrimitiveRenderer::CubeArg cubeArg;
-        cubeArg.setCenter(GetParentNode().lock()->GetPosition());
+        cubeArg.setCenter(worldPosition);
         cubeArg.setColor({1, 1, 1, 1});
         cubeArg.setSize(GetParentNode().lock()->GetScale());
         rio::PrimitiveRenderer::instance()->drawCube(cubeArg);
@@ -66,14 +115,14 @@ void PrimitiveProperty::Update()
     {
         rio::Vector3f parentScale = GetParentNode().lock()->GetScale();
         f32 scale = (parentScale.x + parentScale.y + parentScale.z) / 3;
-        rio::PrimitiveRenderer::instance()->drawAxis(GetParentNode().lock()->GetPosition(), scale);
+        rio::PrimitiveRenderer::instance()->drawAxis(worldPosition, scale);
         break;
     }
     case SHAPE_TYPE_CYLINDER:
     {
         rio::Vector3f parentScale = GetParentNode().lock()->GetScale();
         f32 radius = (parentScale.x + parentScale.z) / 2;
-        rio::PrimitiveRenderer::instance()->drawCylinder32(GetParentNode().lock()->GetPosition(), radius, parentScale.y, mShapeColor);
+        rio::PrimitiveRenderer::instance()->drawCylinder32(worldPosition, radius, parentScale.y, mShapeColor);
         break;
     }
     }
@@ -139,7 +139,6 @@ void CameraProperty::Update()
     // Calculate matrix
     rio::MemUtil::copy(&mProjMtx, &proj.getMatrix(), sizeof(rio::Matrix44f));
 
-    rio::PrimitiveRenderer::instance()->setCamera(mCamera);
     rio::AudioMgr::instance()->setListener(GetParentNode().lock()->GetPosition(), mCamera.at(), mCamera.getUp());
 }
 
@@ -2,8 +2,14 @@
 #include <rio.h>
 #include <helpers/common/NodeMgr.h>
 #include <helpers/common/FFLMgr.h>
+#include <helpers/common/FrameUniformMgr.h>
+#include <helpers/common/JobSystem.h>
+#include <helpers/common/LoadBenchmark.h>
+#include <helpers/common/MatrixBenchmark.h>
 #include <helpers/editor/EditorMgr.h>
 
+#include <cstring>
+
 static const rio::InitializeArg cInitializeArg = {
     .window = {
 #if RIO_IS_WIN
@@ -23,13 +29,33 @@ int main(int argc, char *argv[])
     EditorMgr::createSingleton();
     NodeMgr::createSingleton();
     FFLMgr::createSingleton();
-    rio::EnterMainLoop();
+
+    if (!FrameUniformMgr::createSingleton())
+    {
+        rio::Exit();
+        EditorMgr::destorySingleton();
+        NodeMgr::destorySingleton();
+        FFLMgr::destorySingleton();
+
+        return -1;
+    }
+
+    JobSystem::createSingleton();
+
+    if (argc > 1 && std::strcmp(argv[1], "--benchmark-load") == 0)
+        LoadBenchmark::Run();
+    else if (argc > 1 && std::strcmp(argv[1], "--benchmark-matrix") == 0)
+        MatrixBenchmark::Run();
+    else
+        rio::EnterMainLoop();
 
     // Exit RIO
     rio::Exit();
     EditorMgr::destorySingleton();
     NodeMgr::destorySingleton();
     FFLMgr::destorySingleton();
+    FrameUniformMgr::destorySingleton();
+    JobSystem::destorySingleton();
 
     return 0;
 }